@@ -0,0 +1,35 @@
+# writes OUTPUT, a source file holding every shader in SHADER_DIR as a string constant
+# with its content hash computed by the compiler (see include/EmbeddedShaders.h)
+#   cmake -DSHADER_DIR=<dir> -DOUTPUT=<file.cpp> -P EmbedShaders.cmake
+
+file(GLOB SHADERS RELATIVE ${SHADER_DIR} ${SHADER_DIR}/*.vert ${SHADER_DIR}/*.frag)
+list(SORT SHADERS)
+
+set(BODY "// generated from ${SHADER_DIR} by cmake/EmbedShaders.cmake, do not edit\n")
+string(APPEND BODY "#include \"EmbeddedShaders.h\"\n\n")
+
+set(TABLE "")
+set(INDEX 0)
+foreach(NAME ${SHADERS})
+    file(READ ${SHADER_DIR}/${NAME} SOURCE)
+    string(FIND "${SOURCE}" ")glsl\"" CLASH)
+    if (NOT CLASH EQUAL -1)
+        message(FATAL_ERROR "${NAME} contains the raw string delimiter )glsl\"")
+    endif()
+
+    string(APPEND BODY "static constexpr char kSource${INDEX}[] = R\"glsl(${SOURCE})glsl\";\n")
+    string(APPEND BODY "static constexpr uint64_t kHash${INDEX} = ShaderSourceHash(kSource${INDEX}, sizeof(kSource${INDEX}) - 1);\n\n")
+    string(APPEND TABLE "    {\"${NAME}\", kSource${INDEX}, sizeof(kSource${INDEX}) - 1, kHash${INDEX}},\n")
+    math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+string(APPEND BODY "const EmbeddedShader EMBEDDED_SHADERS[] = {\n${TABLE}};\n")
+string(APPEND BODY "const size_t EMBEDDED_SHADER_COUNT = ${INDEX};\n")
+
+# only touch the output when it changes, so unrelated reconfigures don't rebuild it
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} OLD)
+endif()
+if (NOT "${OLD}" STREQUAL "${BODY}")
+    file(WRITE ${OUTPUT} "${BODY}")
+endif()
@@ -0,0 +1,93 @@
+#version 120
+#extension GL_ARB_uniform_buffer_object : enable
+varying vec3 vNormalWS;
+varying vec3 vPosWS;
+#ifdef TARGET
+varying vec2 vDisc;
+#endif
+
+// per-frame constants shared by every program (FrameUniforms.h)
+#ifdef GL_ARB_uniform_buffer_object
+layout(std140) uniform Frame {
+  mat4 uView;
+  mat4 uProj;
+  vec4 uLightPos;
+  vec4 uViewPos;
+  vec4 uFog;
+};
+#else
+uniform vec4 uLightPos;
+uniform vec4 uViewPos;
+uniform vec4 uFog;
+#endif
+
+struct Material {
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+  float shininess;
+};
+uniform Material uMat;
+
+#ifdef TARGET
+// target rings from the outside in, radii relative to the outer one
+uniform float uRingRadius[3];
+uniform vec3 uRingColor[3];
+#endif
+
+void main()
+{
+  vec3 matAmbient = uMat.ambient;
+  vec3 matDiffuse = uMat.diffuse;
+  float alpha = 1.0;
+#ifdef TARGET
+  // ring color from radial distance, blended across one pixel at each edge
+  float r = length(vDisc);
+  float w = fwidth(r);
+  vec3 ring = uRingColor[2];
+  ring = mix(ring, uRingColor[1], smoothstep(uRingRadius[2] - w, uRingRadius[2] + w, r));
+  ring = mix(ring, uRingColor[0], smoothstep(uRingRadius[1] - w, uRingRadius[1] + w, r));
+  alpha = 1.0 - smoothstep(uRingRadius[0] - w, uRingRadius[0] + w, r);
+  if (alpha <= 0.0)
+    discard;
+  matAmbient *= ring;
+  matDiffuse *= ring;
+#endif
+
+  // lighting calculations
+  vec3 norm = normalize(vNormalWS);
+  vec3 lightDir = normalize(uLightPos.xyz - vPosWS);
+  vec3 viewDir = normalize(uViewPos.xyz - vPosWS);
+#ifdef TARGET
+  // the disc is lit from both sides
+  norm = faceforward(norm, -lightDir, norm);
+#endif
+
+#ifdef BLINN
+  // Blinn-Phong: half vector, exponent scaled to keep a similar highlight size
+  vec3 halfDir = normalize(lightDir + viewDir);
+  float spec = pow(max(dot(norm, halfDir), 0.0), uMat.shininess * 4.0);
+#else
+  // Phong model
+  vec3 reflectDir = reflect(-lightDir, norm);
+  float spec = pow(max(dot(viewDir, reflectDir), 0.0), uMat.shininess);
+#endif
+  vec3 ambient = matAmbient;
+  vec3 diffuse = matDiffuse * max(dot(norm, lightDir), 0.0);
+  vec3 specular = uMat.specular * spec;
+
+  vec3 color = ambient + diffuse + specular;
+#ifdef FOG
+  // exponential squared fog toward uFog.rgb with distance from the eye (as GL_EXP2)
+  float dist = length(uViewPos.xyz - vPosWS) * uFog.a;
+  color = mix(uFog.rgb, color, exp(-dist * dist));
+#endif
+  gl_FragColor = vec4(color, alpha);
+  // mixed color 1
+  // gl_FragColor = vec4(abs(sin(vPosWS.x)), abs(sin(vPosWS.z)), 0.5, 1.0);
+
+  // mixed color 2
+  // vec3 tint = vec3(abs(sin(vPosWS.x)), abs(sin(vPosWS.z)), 0.5);
+  // vec3 finalColor = mix(color, tint, 0.4);
+  // gl_FragColor = vec4(finalColor, 1.0);
+}
@@ -0,0 +1,71 @@
+#version 120
+#extension GL_ARB_uniform_buffer_object : enable
+// scene shader, every solid is drawn with it (wave.vert feeds the same scene.frag);
+// variants are built by ShaderVariants with these macros defined:
+//   BLINN, FOG (fragment only), INSTANCED, PACKED_NORMALS, TARGET (see SceneFeature)
+
+attribute vec3 aPos;
+#ifdef PACKED_NORMALS
+attribute vec2 aNormal; // octahedral encoding, normalized to [-1, 1]
+#else
+attribute vec3 aNormal;
+#endif
+
+// per-frame constants shared by every program (FrameUniforms.h)
+#ifdef GL_ARB_uniform_buffer_object
+layout(std140) uniform Frame {
+  mat4 uView;
+  mat4 uProj;
+  vec4 uLightPos;
+  vec4 uViewPos;
+  vec4 uFog;
+};
+#else
+uniform mat4 uView;
+uniform mat4 uProj;
+#endif
+
+#ifdef INSTANCED
+attribute mat4 aInstanceModel; // per instance (attribute divisor 1), uniform scale only
+#else
+uniform mat4 uModel;
+uniform mat3 uNormalMatrix;
+#endif
+
+varying vec3 vNormalWS;
+varying vec3 vPosWS;
+#ifdef TARGET
+varying vec2 vDisc; // position on the target disc, outer ring radius is 1
+#endif
+
+#ifdef PACKED_NORMALS
+// unit vector from its octahedral encoding (lower hemisphere folded over the diagonals)
+vec3 decodeNormal(vec2 e)
+{
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  if (n.z < 0.0)
+    n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  return normalize(n);
+}
+#endif
+
+void main() {
+#ifdef PACKED_NORMALS
+  vec3 normal = decodeNormal(aNormal);
+#else
+  vec3 normal = aNormal;
+#endif
+
+#ifdef INSTANCED
+  vec4 posWS = aInstanceModel * vec4(aPos, 1.0);
+  vNormalWS = normalize(mat3(aInstanceModel) * normal);
+#else
+  vec4 posWS = uModel * vec4(aPos, 1.0);
+  vNormalWS = normalize(uNormalMatrix * normal);
+#endif
+  vPosWS = posWS.xyz;
+#ifdef TARGET
+  vDisc = aPos.xy;
+#endif
+  gl_Position = uProj * uView * posWS;
+}
@@ -0,0 +1,77 @@
+#version 120
+#extension GL_ARB_uniform_buffer_object : enable
+// animated water, shaded by scene.frag: vertices flagged in aSurface ride the surface
+//   y = lift + amp * sin(2 pi * ((x - x0) * cyclesPerX - speed * time))
+// evaluated exactly like waveYAtBatch (WaveEval.cpp) so ducks placed on the cpu
+// sit on the drawn surface
+uniform vec4 uWave;   // x0, cycles per x, lift, amp
+uniform float uSpeed; // cycles per second
+uniform float uTime;  // seconds
+uniform vec3 uSlide;  // x shift of the sliding vertices (a fraction of a wavelength), x0, x1
+
+attribute vec3 aPos;
+attribute vec3 aNormal;
+attribute vec3 aSurface; // x: height follows the surface, y: normal follows the slope,
+                         // z: x slides with the crests (WaveMesh::Sample)
+
+// per-frame constants shared by every program (FrameUniforms.h)
+#ifdef GL_ARB_uniform_buffer_object
+layout(std140) uniform Frame {
+  mat4 uView;
+  mat4 uProj;
+  vec4 uLightPos;
+  vec4 uViewPos;
+  vec4 uFog;
+};
+#else
+uniform mat4 uView;
+uniform mat4 uProj;
+#endif
+
+uniform mat4 uModel;
+uniform mat3 uNormalMatrix;
+
+varying vec3 vNormalWS;
+varying vec3 vPosWS;
+
+// sin(2 pi p): quarter-turn folding and the same degree 11 polynomial as the cpu
+float waveSin(float p)
+{
+  float f = p - floor(p + 0.5);
+  float s = f < 0.0 ? -0.5 : 0.5;
+  if (abs(f) > 0.25)
+    f = s - f;
+  float f2 = f * f;
+  float r = -15.0946425768;
+  r = r * f2 + 42.0586939449;
+  r = r * f2 - 76.7058597531;
+  r = r * f2 + 81.6052492761;
+  r = r * f2 - 41.3417022404;
+  r = r * f2 + 6.28318530718;
+  return r * f;
+}
+
+void main() {
+  vec4 pos = vec4(aPos, 1.0);
+  vec3 normal = aNormal;
+
+  // samples travel with the wave so each keeps the phase it was placed for; the ones
+  // pushed past an edge collapse onto it
+  if (aSurface.z > 0.5)
+    pos.x = clamp(pos.x + uSlide.x, uSlide.y, uSlide.z);
+
+  float p = (pos.x - uWave.x) * uWave.y - uSpeed * uTime;
+  if (aSurface.x > 0.5)
+    pos.y = uWave.z + uWave.w * waveSin(p);
+  if (aSurface.y > 0.5)
+  {
+    // slope from cos(2 pi p) = sin(2 pi (p + 1/4))
+    float slope = uWave.w * 6.28318530718 * uWave.y * waveSin(p + 0.25);
+    normal = normalize(vec3(-slope, 1.0, 0.0));
+  }
+
+  vec4 posWS = uModel * pos;
+  vNormalWS = normalize(uNormalMatrix * normal);
+  vPosWS = posWS.xyz;
+  gl_Position = uProj * uView * posWS;
+}
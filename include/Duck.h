@@ -22,6 +22,7 @@
 
 // project includes
 #include "QuadMesh.h"
+#include "RenderQueue.h"
 
 // window size
 extern const int vWidth;
@@ -45,6 +46,8 @@ struct WaveParams
   float baseY = 0.0f;  // base y for filling water
   float x0 = 0.0f;     // left edge x of water
   float x1 = 0.0f;     // right edge x of water
+  float speed = 0.0f;  // wave travel in cycles per second (animated in wave.vert)
+  float time = 0.0f;   // animation time in seconds, wrapped to one period
 };
 
 // booth layout parameters that position the duck/stage
@@ -77,12 +80,26 @@ struct BoothLayout
   float beamCenterY = 0.0f;    // beam center y
 };
 
+// duck target rings, listed from the outside in
+struct TargetRing
+{
+  float radius;   // outer radius of the ring in duck units (exact, used for scoring)
+  int score;      // points for a hit inside this ring
+  float color[3]; // ring color
+};
+const int TARGET_RING_COUNT = 3;
+extern const TargetRing TARGET_RINGS[TARGET_RING_COUNT];
+
 // global instances (defined in Duck3D.cpp)
 extern WaveParams gWave;
 extern BoothLayout gBooth;
 
 // get wave height at x position
 float waveYAt(float x);
+// wave heights ys[i] for xs[i], i < n (simd polynomial sine, see WaveEval.cpp)
+void waveYAtBatch(const float *xs, float *ys, size_t n);
+// same for any wave, not just gWave
+void waveYAtBatch(const WaveParams &wave, const float *xs, float *ys, size_t n);
 
 // set up scene parameters (booth, wave, sizes)
 void setupSceneParams();
@@ -94,19 +111,20 @@ void reshape(int w, int h);
 void keyboard(unsigned char key, int x, int y);
 void animationHandler(int value);
 
-// duck drawing functions (each draws part of the duck)
-void drawDuck();
-void drawDuckBody();
-void drawDuckHead();
-void drawDuckEyes();
-void drawDuckBeak();
-void drawDuckNeck();
-void drawDuckTail();
-void drawDuckTarget();
+// duck drawing functions (each records part of the duck into a list of the frame's
+// render queue, model places the duck in the world; lists may be filled on any thread)
+void drawDuck(RenderQueue::List &list, const glm::mat4 &model);
+void drawDuckBody(RenderQueue::List &list, const glm::mat4 &model);
+void drawDuckHead(RenderQueue::List &list, const glm::mat4 &model);
+void drawDuckEyes(RenderQueue::List &list, const glm::mat4 &model);
+void drawDuckBeak(RenderQueue::List &list, const glm::mat4 &model);
+void drawDuckNeck(RenderQueue::List &list, const glm::mat4 &model);
+void drawDuckTail(RenderQueue::List &list, const glm::mat4 &model);
+void drawDuckTarget(RenderQueue::List &list, const glm::mat4 &model); // blended pass
 void drawDuckStand();
 
 // environment drawing functions
-void drawBooth();
-void drawWaterWave3D();
+void drawBooth(RenderQueue &queue);
+void drawWaterWave3D(RenderQueue &queue);
 
 #endif
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Ocean;
+
+// duck animation states (stored as int32 in DuckBatch::state)
+// states advance in order FORWARD -> TURN_AT_RIGHT -> BACKWARD -> TURN_AT_LEFT -> FORWARD
+enum DuckState
+{
+  FORWARD = 0,
+  TURN_AT_RIGHT = 1,
+  BACKWARD = 2,
+  TURN_AT_LEFT = 3
+};
+
+// constants shared by every duck in a batch (filled from the wave each tick)
+struct DuckSimParams
+{
+  float moveSpeed = 0.06f;  // forward/backward step per tick
+  float spinSpeed = 4.0f;   // degrees per tick during turning
+  float flipSpeed = 5.0f;   // degrees per tick for target flip
+  float rideOffset = 0.10f; // how far the duck sits below the wave surface
+  float turnRadius = 0.0f;  // radius of the turn at either edge
+  float x0 = 0.0f;          // left edge of the wave
+  float x1 = 0.0f;          // right edge of the wave
+  const Ocean *ocean = nullptr; // when set, ducks ride this height field instead of the sine wave
+};
+
+// struct-of-arrays duck state: one entry per duck in every array
+struct DuckBatch
+{
+  std::vector<float> x, y, z;        // duck position
+  std::vector<float> spinDeg;        // current spin angle while turning
+  std::vector<float> pivotX, pivotY; // turn pivot (set when an edge is reached)
+  std::vector<float> flipAngle;      // target tilt around x axis (degrees)
+  std::vector<int32_t> state;        // DuckState
+  std::vector<int32_t> flipping;     // 1 while flipping down
+  std::vector<int32_t> flipped;      // 1 when fully flipped down
+
+  size_t size() const { return x.size(); }
+  // grow/shrink every array, new ducks start moving forward at the origin
+  void resize(size_t n);
+};
+
+// place ducks in lanes behind the booth with staggered start positions
+// duck 0 always starts at startX on lane z = 0
+void InitDuckBatch(DuckBatch &ducks, size_t count, const DuckSimParams &params, float startX);
+
+// start the target flip on every duck in [begin, end) that is moving forward and upright
+void RequestDuckFlip(DuckBatch &ducks, size_t begin, size_t end);
+
+// advance ducks [begin, end) by one tick
+void StepDuckBatch(DuckBatch &ducks, const DuckSimParams &params, size_t begin, size_t end);
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// shader sources compiled into the executable: the build runs cmake/EmbedShaders.cmake
+// over data/shaders and generates EmbeddedShaders.cpp with one string constant per file
+// and its content hash, evaluated by the compiler. the game then needs no shader files
+// at runtime, and program cache keys come from the stored hashes instead of rehashing text
+struct EmbeddedShader
+{
+  const char *name;   // file name, e.g. "scene.vert"
+  const char *source; // file contents
+  size_t length;      // bytes in source
+  uint64_t hash;      // ShaderSourceHash of source
+};
+
+// 64-bit fnv-1a of a shader source (constexpr so the embedded table is hashed at build time)
+constexpr uint64_t ShaderSourceHash(const char *s, size_t n)
+{
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < n; i++)
+  {
+    h ^= (unsigned char)s[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+inline uint64_t ShaderSourceHash(const std::string &s)
+{
+  return ShaderSourceHash(s.data(), s.size());
+}
+
+// generated table, sorted by name
+extern const EmbeddedShader EMBEDDED_SHADERS[];
+extern const size_t EMBEDDED_SHADER_COUNT;
+
+// embedded shader by file name, nullptr when the build had none by that name
+const EmbeddedShader *FindEmbeddedShader(const std::string &name);
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+
+// how finished frames reach the screen (--present)
+enum PresentMode
+{
+	PRESENT_VSYNC,		// wait for the vertical blank (swap interval 1)
+	PRESENT_ADAPTIVE, // vsync, but a late frame swaps at once and tears (swap_control_tear, interval -1)
+	PRESENT_UNCAPPED, // never wait (interval 0)
+	PRESENT_FIXED,		// interval 0, held back on the cpu to a target rate (--fps)
+};
+
+// frame pacing: sets the swap interval for the chosen mode and, in fixed mode, holds each
+// present back to its deadline by sleeping until shortly before it and spinning the rest
+// (a sleep alone overshoots by the scheduler's granularity). deadlines advance by one period
+// from the previous deadline rather than from when the frame finished, so the rate does not
+// drift; a frame more than a period late restarts the schedule instead of bursting to catch up
+//
+// Presented records the real time between swaps, reported once a second when logging
+class FramePacer
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	// parse a --present argument, false when unknown
+	static bool ParseMode(const char *name, PresentMode &mode);
+	static const char *ModeName(PresentMode mode);
+
+	// apply mode to the current context (fixedHz is the fixed mode's rate); a mode the driver
+	// can't set falls back: adaptive to vsync, vsync to fixed at fixedHz
+	void Init(PresentMode mode, double fixedHz, bool logIntervals);
+
+	// block until this frame may be presented (fixed mode only), right before the swap
+	void WaitForPresent();
+	// the swap was issued: record the interval since the previous one
+	void Presented();
+
+	// mode actually in use after any fallback
+	PresentMode Mode() const { return mode; }
+
+private:
+	PresentMode mode = PRESENT_VSYNC;
+	Clock::duration period{};		// fixed mode frame period
+	Clock::time_point deadline{}; // fixed mode: when the next frame presents
+	bool scheduled = false;				// deadline is valid
+
+	// present interval log (one line per second)
+	bool log = false;
+	bool timing = false; // lastPresent is valid
+	Clock::time_point lastPresent{}, windowStart{};
+	int frames = 0;
+	double sumMs = 0.0, minMs = 0.0, maxMs = 0.0;
+};
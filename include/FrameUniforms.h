@@ -0,0 +1,57 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class ShaderProgram;
+class StreamBuffer;
+
+// per-frame constants shared by every program through one std140 uniform block,
+// written once per frame however many programs and draws read it. shaders declare
+//
+//   #extension GL_ARB_uniform_buffer_object : enable
+//   #ifdef GL_ARB_uniform_buffer_object
+//   layout(std140) uniform Frame { mat4 uView; mat4 uProj; vec4 uLightPos; vec4 uViewPos; vec4 uFog; };
+//   #else
+//   uniform mat4 uView; uniform mat4 uProj; uniform vec4 uLightPos; uniform vec4 uViewPos; uniform vec4 uFog;
+//   #endif
+//
+// and ShaderProgram binds the block to FRAME_BLOCK_BINDING when it reflects a program.
+// drivers without uniform buffers get the same names as plain uniforms (see Apply)
+struct FrameBlock
+{
+	glm::mat4 view;
+	glm::mat4 proj;
+	glm::vec4 lightPos; // world space, w unused
+	glm::vec4 viewPos;	// camera position, w unused
+	glm::vec4 fog;			// fog color (rgb) and density per world unit (a), for the FOG variants
+};
+
+static const char *const FRAME_BLOCK_NAME = "Frame";
+static const GLuint FRAME_BLOCK_BINDING = 0;
+
+// each Update writes a fresh copy of the block into the frame's StreamBuffer space and
+// binds that range, so the gpu can still read the previous frames' values while the cpu
+// fills the new one. the StreamBuffer does the synchronizing (a fence per region, or
+// orphaning), so the block is never written where a draw in flight reads it
+class FrameUniforms
+{
+public:
+	FrameUniforms() = default;
+
+	FrameUniforms(const FrameUniforms &) = delete;
+	FrameUniforms &operator=(const FrameUniforms &) = delete;
+
+	// true when the driver has uniform buffers (checked once a context exists)
+	static bool Supported();
+
+	// write this frame's values into stream and bind them
+	void Update(const FrameBlock &frame, StreamBuffer &stream);
+
+	// fallback for drivers without uniform buffers: set the block's members as plain
+	// uniforms on prog (bound); no-op when the buffer is in use
+	void Apply(ShaderProgram &prog) const;
+
+private:
+	GLint align = 0;		// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried on first Update
+	FrameBlock last{};	// values for Apply
+};
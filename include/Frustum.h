@@ -0,0 +1,21 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// view frustum as six world-space planes taken from a projection * view matrix
+// (normals point inside, unit length so distances are in world units)
+//
+// the planes are stored transposed and padded to eight (the last two repeat the first
+// two), so the sse path tests a volume against four planes per instruction; both tests
+// are conservative: a volume is only dropped when it lies fully behind one plane
+struct Frustum
+{
+  float nx[8], ny[8], nz[8], d[8]; // plane i: nx[i] * x + ny[i] * y + nz[i] * z + d[i] >= 0 inside
+};
+
+// planes of viewProj's clip volume (left, right, bottom, top, near, far)
+Frustum MakeFrustum(const glm::mat4 &viewProj);
+
+// false when the sphere is certainly outside
+bool SphereInFrustum(const Frustum &f, const glm::vec3 &center, float radius);
+// false when the axis aligned box [lo, hi] is certainly outside
+bool BoxInFrustum(const Frustum &f, const glm::vec3 &lo, const glm::vec3 &hi);
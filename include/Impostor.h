@@ -0,0 +1,38 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// octahedral impostor atlas: an object rendered once from grid*grid directions spread
+// over the whole sphere, so far copies can be drawn as one textured quad each
+struct ImpostorAtlas
+{
+  GLuint texture = 0;     // rgba atlas, grid*cellSize pixels square
+  int grid = 0;           // cells per side
+  int cellSize = 0;       // pixels per cell side
+  glm::vec3 center{0.0f}; // bounding sphere center in object space
+  float radius = 0.0f;    // bounding sphere radius (quad half size)
+};
+
+// one billboard to draw: object-space view direction picks the cell,
+// the quad is centered on worldCenter and faces eye
+struct ImpostorQuad
+{
+  glm::vec3 worldCenter; // bounding sphere center in world space
+  glm::vec3 toEyeLocal;  // direction to the eye in object space (normalized)
+  glm::vec3 toEyeWorld;  // direction to the eye in world space (normalized)
+  glm::vec3 bakeUpWorld; // the cell's bake up vector in world space
+  glm::vec4 uv;          // atlas rect (u0, v0, u1, v1)
+  float alpha;           // crossfade weight
+};
+
+// render draw() into the atlas from every cell direction, draw gets the cell's camera
+// returns false (and leaves the atlas empty) when framebuffer objects are unavailable
+bool BakeImpostorAtlas(ImpostorAtlas &atlas, int grid, int cellSize, glm::vec3 center, float radius,
+                       void (*draw)(const glm::mat4 &view, const glm::mat4 &proj));
+void DestroyImpostorAtlas(ImpostorAtlas &atlas);
+
+// fill quad for an object with the given model matrix seen from eye
+ImpostorQuad MakeImpostorQuad(const ImpostorAtlas &atlas, const glm::mat4 &model, const glm::vec3 &eye, float alpha);
+
+// draw quads in one immediate-mode batch (modelview must hold the camera view)
+void DrawImpostors(const ImpostorAtlas &atlas, const ImpostorQuad *quads, size_t count);
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads that run parallel-for jobs split into fixed-size chunks
+// the calling thread works on chunks too, and ParallelFor only returns once every
+// chunk is finished, so it doubles as the frame barrier before rendering reads results
+class JobPool
+{
+public:
+	// threadCount counts the calling thread; 0 picks the hardware concurrency
+	explicit JobPool(unsigned threadCount = 0);
+	~JobPool();
+
+	JobPool(const JobPool &) = delete;
+	JobPool &operator=(const JobPool &) = delete;
+
+	// total threads working on a job (workers + caller)
+	unsigned ThreadCount() const { return (unsigned)workers.size() + 1; }
+
+	// run fn(begin, end) over [0, count) in chunks of chunkSize and wait for all of them
+	// chunk boundaries depend only on count and chunkSize, never on the thread count
+	void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)> &fn);
+
+private:
+	// claim and run chunks of the current job until none are left
+	void RunChunks();
+	void WorkerLoop();
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake; // workers wait here for a new job
+	std::condition_variable done; // caller waits here for the job to finish
+
+	// current job (only changed by the caller while no worker is active)
+	const std::function<void(size_t, size_t)> *job = nullptr;
+	size_t jobCount = 0;
+	size_t jobChunk = 1;
+	size_t numChunks = 0;
+	std::atomic<size_t> nextChunk{0};
+	size_t chunksDone = 0;
+
+	unsigned generation = 0; // bumped for every job so workers see new work
+	unsigned activeWorkers = 0;
+	bool quit = false;
+};
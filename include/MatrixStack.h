@@ -0,0 +1,39 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+// cpu stand-in for the fixed-function modelview stack: the same push / pop / translate /
+// rotate / scale sequence, composed with glm and read back with Top() as the model matrix
+// of a render queue draw, so building a hierarchy costs arithmetic instead of driver calls
+//
+// results are plain matrices, so parts whose transform never changes are composed once
+// and kept (see the duck and booth part tables in Duck3D.cpp)
+class MatrixStack
+{
+public:
+	MatrixStack() : stack(1, glm::mat4(1.0f)) {}
+
+	// duplicate the top so later operations can be undone with Pop
+	void Push() { stack.push_back(stack.back()); }
+	void Pop()
+	{
+		if (stack.size() > 1)
+			stack.pop_back();
+	}
+
+	void LoadIdentity() { stack.back() = glm::mat4(1.0f); }
+	void Load(const glm::mat4 &m) { stack.back() = m; }
+	void Mult(const glm::mat4 &m) { stack.back() *= m; }
+
+	// each operation applies in the local frame of the ones before it, like glTranslatef etc.
+	void Translate(const glm::vec3 &v) { stack.back() = glm::translate(stack.back(), v); }
+	void Rotate(float degrees, const glm::vec3 &axis) { stack.back() = glm::rotate(stack.back(), glm::radians(degrees), axis); }
+	void Scale(const glm::vec3 &v) { stack.back() = glm::scale(stack.back(), v); }
+
+	const glm::mat4 &Top() const { return stack.back(); }
+	size_t Depth() const { return stack.size(); }
+
+private:
+	std::vector<glm::mat4> stack;
+};
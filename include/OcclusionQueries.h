@@ -0,0 +1,48 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// hardware occlusion culling for a set of objects known by index (the ducks)
+//
+// after the scene is drawn, each tested object draws a cheap proxy (its bounding box,
+// PASS_OCCLUSION in the render queue) inside a GL_SAMPLES_PASSED query. the next frame
+// Poll picks up the queries that finished and Visible(i) is asked before drawing the
+// object; a query the gpu has not reached yet keeps the previous answer, so the cpu never
+// waits on a result. a hidden object still draws its proxy every frame and shows up again
+// one frame after it becomes visible
+//
+// only Resize and Poll call gl; Visible, Reset and Issue just touch object i's slot, so
+// different objects can be handled on different threads in between
+class OcclusionQueries
+{
+public:
+	OcclusionQueries() = default;
+	~OcclusionQueries();
+
+	OcclusionQueries(const OcclusionQueries &) = delete;
+	OcclusionQueries &operator=(const OcclusionQueries &) = delete;
+
+	// true when the driver has occlusion queries (checked once a context exists)
+	static bool Supported();
+
+	// one slot (and query object) per object, new slots start visible
+	void Resize(size_t count);
+
+	// read the results of the queries that finished since the last call (gl thread)
+	void Poll();
+
+	// latest known answer for object i
+	bool Visible(size_t i) const { return visible[i] != 0; }
+	// object i was not tested this frame (e.g. frustum culled), its answer is stale:
+	// count it as visible until a new query says otherwise
+	void Reset(size_t i);
+	// query for this frame's proxy of object i, 0 while the last one is still in flight
+	GLuint Issue(size_t i);
+
+private:
+	std::vector<GLuint> queries;
+	std::vector<uint8_t> pending; // query issued, result not read yet
+	std::vector<uint8_t> visible; // last answer
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+class JobPool;
+
+// spectral ocean height field (phillips spectrum) on an n x n periodic patch
+// every Update evolves the spectrum to a time and runs a 2d inverse fft on the
+// job pool; heights then tile across the xz plane and can be sampled anywhere
+class Ocean
+{
+public:
+	// size: fft size per side (power of two, 64 to 512)
+	// patchSize: world units covered by one tile
+	// windSpeed / windDirX, windDirZ: phillips wind (m/s, direction in xz)
+	// heightRms: rms of the height field (spectrum is scaled to hit it at time 0)
+	// baseHeight: added to every sampled height
+	Ocean(int size, float patchSize, float windSpeed, float windDirX, float windDirZ, float heightRms,
+				float baseHeight, unsigned seed = 1);
+
+	static bool ValidSize(int size) { return size >= 64 && size <= 512 && (size & (size - 1)) == 0; }
+
+	// evolve to time (seconds, the spectrum repeats every LoopPeriod) and rebuild heights
+	// runs on jobs and returns once the new heights are complete
+	void Update(float time, JobPool &jobs);
+
+	// bilinear height at world x, z (tiles every PatchSize)
+	float Height(float x, float z) const;
+	// ys[i] = Height(xs[i], zs[i]) for i < n
+	void SampleHeights(const float *xs, const float *zs, float *ys, size_t n) const;
+
+	int Size() const { return n; }
+	float PatchSize() const { return patch; }
+	float LoopPeriod() const { return loopPeriod; }
+
+private:
+	typedef std::complex<float> Complex;
+
+	// in-place inverse fft of rows [begin, end) of an n x n array
+	void FftRows(Complex *data, size_t begin, size_t end) const;
+
+	int n = 0, logN = 0;
+	float patch = 0.0f;
+	float loopPeriod = 0.0f; // angular frequencies are multiples of 2 pi / loopPeriod
+	float base = 0.0f;
+
+	std::vector<Complex> h0;			 // initial spectrum h0(k), scaled so heights hit heightRms
+	std::vector<Complex> h0MinusConj; // conj(h0(-k)), so the evolved field stays real
+	std::vector<unsigned> omegaStep; // dispersion w(k) = sqrt(g |k|) as a multiple of 2 pi / loopPeriod
+	unsigned maxStep = 0;					 // largest omegaStep
+	std::vector<Complex> phase;			 // e^(i m w0 t) for the current time, m <= maxStep
+
+	std::vector<unsigned> bitrev; // bit reversal permutation for one row
+	std::vector<float> twiddleRe, twiddleIm; // per fft stage twiddles, see FftRows
+
+	std::vector<Complex> spectrum; // evolved spectrum, then row-transformed (row = z)
+	std::vector<Complex> columns;	 // transposed copy for the column pass (row = x)
+	std::vector<float> heights;		 // final heights, z-major: heights[z * n + x]
+};
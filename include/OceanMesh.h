@@ -0,0 +1,46 @@
+#pragma once
+#include "QuadMesh.h"
+#include "RenderQueue.h"
+#include <vector>
+
+class Ocean;
+class StreamBuffer;
+
+// booth water drawn from an Ocean: a grid over the water rectangle plus side
+// skirts down to the base. indices are built once, positions and normals are
+// resampled from the height field every Update and written to a StreamBuffer
+// every frame the water is drawn
+class OceanMesh
+{
+private:
+	float step;							// grid spacing in x and z
+	float x0 = 0, x1 = 0;		// water rectangle in x
+	float z0 = 0, z1 = 0;		// water rectangle in z
+	float baseY = 0;				// bottom of the water solid
+	int nx = 0, nz = 0;			// grid samples per side
+	bool ready = false;			// true once Init built the buffers
+
+	std::vector<float> xs, zs, ys;		 // grid sample positions and sampled heights
+	std::vector<MeshVertex> vertices;	 // current surface, streamed every frame
+	std::vector<unsigned int> indices; // triangle list (static)
+
+	GLuint ebo = 0;					 // index buffer (static)
+	GLuint streamVbo = 0;		 // buffer and offset of this frame's vertices (see Stream)
+	GLintptr streamOffset = 0;
+
+public:
+	explicit OceanMesh(float step = 0.08f) : step(step) {}
+
+	// lay out the grid over [x0, x1] x [z0, z1] and create the buffers
+	void Init(float x0, float x1, float z0, float z1, float baseY);
+
+	// resample heights and recompute normals
+	void Update(const Ocean &ocean);
+
+	// write the vertices into this frame's stream space, before Layout
+	void Stream(StreamBuffer &stream);
+
+	// vertex arrays for the render queue (aPos / aNormal), empty when not streamed this frame
+	// (no vertex array object: the stream offset moves every frame)
+	RenderMesh Layout() const;
+};
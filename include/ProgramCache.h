@@ -0,0 +1,40 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// on-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary)
+// entries are keyed by the content hashes of the shader sources and the gl vendor,
+// renderer and version strings, so an edited shader or a driver update simply misses
+
+// cache hit/miss counts since startup
+struct ProgramCacheStats
+{
+  int hits = 0;   // programs restored from a binary
+  int misses = 0; // programs compiled from source (no entry, or entry rejected)
+};
+
+// true when the context can save and restore program binaries
+bool ProgramBinarySupported();
+
+// directory holding cache files (default "cache" in the working directory, set by --cache),
+// created on first store
+void SetProgramCacheDir(const std::string &dir);
+
+// key from the content hashes of a program's pieces (ShaderSourceHash of each source and
+// of the injected defines, see EmbeddedShaders.h) together with the current driver strings
+uint64_t ProgramCacheKey(std::initializer_list<uint64_t> hashes);
+
+// the driver part on its own (reads gl strings, so gl thread only), and the key from it;
+// the second form touches no gl state and can run on worker threads
+uint64_t ProgramCacheDriverKey();
+uint64_t ProgramCacheKey(std::initializer_list<uint64_t> hashes, uint64_t driverKey);
+
+// program restored from the cache entry for key, or 0 when missing or rejected
+GLuint LoadCachedProgram(uint64_t key);
+
+// save the binary of a freshly linked program under key (no-op when unsupported)
+void StoreCachedProgram(uint64_t key, GLuint program);
+
+ProgramCacheStats GetProgramCacheStats();
@@ -1,4 +1,5 @@
 #pragma once
+#include "RenderQueue.h"
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <vector>
@@ -45,6 +46,7 @@ private:
 	// opengl buffer object ids: 0=pos, 1=norm, 2=ebo
 	GLuint vbos[3] = {0, 0, 0};
 	bool vboReady = false; // true when vbos are created and populated
+	GLuint vao = 0;				 // the vbos and attribute pointers recorded at CreateMeshVBO (0 if unsupported)
 	GLint attrPos = -1;		 // attribute location for position
 	GLint attrNorm = -1;	 // attribute location for normal
 
@@ -77,6 +79,8 @@ public:
 	void CreateMeshVBO(int meshSize, GLint attribVertexPosition, GLint attribVertexNormal);
 	// draw using prepared vbos (fast)
 	void DrawMeshVBO(int meshSize);
+	// the vbos as render queue vertex arrays (empty until CreateMeshVBO)
+	RenderMesh Layout() const;
 
 	// set simple material parameters
 	void SetMaterial(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, double shininess);
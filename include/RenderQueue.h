@@ -0,0 +1,173 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+
+class FrameUniforms;
+class ShaderProgram;
+
+// vertex arrays of a mesh as the queue binds them: attribute streams read from buffers
+// (slots from VertexAttrib, ShaderUtils.h) and an index buffer. meshes whose buffers
+// never move record them once in a vertex array object (RenderQueue::CreateVertexArray),
+// which the queue binds in one call instead of setting up every stream
+struct RenderMesh
+{
+	struct Stream
+	{
+		GLuint buffer = 0;
+		GLuint slot = 0;
+		GLint components = 0; // floats per vertex
+		GLsizei stride = 0;
+		size_t offset = 0;
+	};
+	Stream streams[3];
+	int streamCount = 0;
+	GLuint indexBuffer = 0; // unsigned int indices
+	GLsizei indexCount = 0; // 0 = nothing to draw
+	GLenum mode = GL_TRIANGLES;
+	GLuint vao = 0; // streams and index buffer recorded in a vertex array object, 0 = bind them one by one
+};
+
+// phong material of the scene shader (uMat)
+struct RenderMaterial
+{
+	glm::vec3 ambient{0.0f};
+	glm::vec3 diffuse{0.0f};
+	glm::vec3 specular{0.0f};
+	float shininess = 1.0f;
+};
+
+// opaque draws sort by state, blended ones back to front after them
+enum RenderPass : uint32_t
+{
+	PASS_OPAQUE = 0,
+	PASS_BLENDED = 1,		// alpha blended (src alpha, one minus src alpha)
+	PASS_OCCLUSION = 2, // depth tested proxies that write nothing, each counted by its query
+};
+
+// draws collected over a frame and issued in one go: every draw is a 64-bit sort key
+//   opaque, occlusion: pass(2) program(6) material(12) mesh(12) depth(32)
+//   blended:           pass(2) far-to-near depth(32) program(6) material(12) mesh(12)
+// plus its model matrix. Execute radix sorts the keys and walks them, binding a program,
+// material or mesh only when it differs from the previous draw's
+//
+// programs, materials and meshes are per-frame tables (Begin clears them), their ids are
+// what goes into the keys: up to 64 programs and 4096 materials and meshes
+//
+// large parts of a frame can be recorded on worker threads: each fills its own List,
+// which only reads the queue's tables, and the gl thread Appends the lists in a fixed order
+// before Execute. the radix sort is stable, so the result does not depend on which thread
+// recorded what
+class RenderQueue
+{
+private:
+	struct Draw
+	{
+		glm::mat4 model;
+		uint32_t mesh;
+		uint32_t material;
+		uint32_t program;
+		GLuint query;
+	};
+
+public:
+	// draws recorded by one thread, kept between frames so its storage is reused
+	class List
+	{
+	public:
+		// empty the list and record against queue's current tables
+		void Begin(const RenderQueue &queue);
+		// as RenderQueue::Submit; safe on any thread while nothing is added to the tables
+		void Submit(RenderPass pass, uint32_t program, uint32_t material, uint32_t mesh, const glm::mat4 &model,
+								GLuint query = 0);
+		size_t Size() const { return draws.size(); }
+
+	private:
+		friend class RenderQueue;
+		const RenderQueue *queue = nullptr;
+		std::vector<uint64_t> keys;
+		std::vector<Draw> draws;
+	};
+
+	// called when Execute binds the program, for uniforms that hold for all of its draws
+	typedef std::function<void(ShaderProgram &prog)> BindFn;
+
+	// state changes made by the last Execute
+	struct Stats
+	{
+		int draws = 0;
+		int programs = 0;
+		int materials = 0;
+		int meshes = 0;
+	};
+
+	// start collecting a frame, depth is the distance from eye
+	void Begin(const glm::vec3 &eye);
+
+	// add to the frame's tables and return the id to submit with
+	uint32_t AddProgram(ShaderProgram &prog, BindFn onBind = BindFn());
+	uint32_t AddMesh(const RenderMesh &mesh);
+	// id of an equal material when there is one, added otherwise
+	uint32_t Material(const RenderMaterial &mat);
+
+	// queue one draw of mesh, placed by model; with a query (GL_SAMPLES_PASSED) the draw's
+	// samples are counted into it
+	void Submit(RenderPass pass, uint32_t program, uint32_t material, uint32_t mesh, const glm::mat4 &model,
+							GLuint query = 0);
+	// add list's draws to the queue (gl thread, after recording finished)
+	void Append(const List &list);
+
+	// sort and draw everything submitted since Begin with frame's per-frame uniforms
+	// expects and leaves vertex array object 0 with no buffers bound and no vertex arrays
+	// enabled; leaves program 0 bound, blending off and all writes on
+	void Execute(const FrameUniforms &frame);
+
+	// true when the driver has vertex array objects (checked once a context exists)
+	static bool VertexArraysSupported();
+	// vertex array object recording mesh's streams and index buffer (the buffers must stay
+	// the same, their contents may change), 0 when unsupported; store it in RenderMesh::vao
+	static GLuint CreateVertexArray(const RenderMesh &mesh);
+
+	const Stats &LastStats() const { return stats; }
+	size_t Size() const { return draws.size(); }
+
+private:
+	struct Program
+	{
+		ShaderProgram *prog;
+		BindFn onBind;
+	};
+	// sort key of a draw, false when it would draw nothing or its ids are out of range
+	bool MakeKey(RenderPass pass, uint32_t program, uint32_t material, uint32_t mesh, const glm::mat4 &model,
+							 uint64_t &key) const;
+	// ascending sort of keys/order by key (lsd radix, 8 bits per pass)
+	void Sort();
+	// bind mesh's vertex array object, or enable its streams (disabling slots the previous
+	// mesh used and it doesn't) when it has none
+	void BindMesh(const RenderMesh &mesh);
+	void BindArrayBuffer(GLuint buffer);
+
+	glm::vec3 eye{0.0f};
+	std::vector<Program> programs;
+	std::vector<RenderMaterial> materials;
+	std::vector<RenderMesh> meshes;
+	std::vector<Draw> draws;
+
+	std::vector<uint64_t> keys, keysTmp; // sort keys, keys[i] belongs to draws[order[i]]
+	std::vector<uint32_t> order, orderTmp;
+	// gl bindings as the queue last set them, so calls that would change nothing are skipped
+	// (two meshes sharing a vertex array object or a buffer, a program bound twice in a row)
+	struct BoundState
+	{
+		GLuint vao = 0;
+		GLuint arrayBuffer = 0;
+		GLuint elementBuffer = 0; // of vertex array object 0
+		uint32_t slots = 0;				// attribute slots enabled on vertex array object 0 (bit mask)
+		GLuint program = 0;
+	};
+	BoundState bound;
+	Stats stats;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// linked program with its active uniforms and attributes reflected into flat hash tables
+// (glGetActiveUniform / glGetActiveAttrib), so callers set uniforms by name instead of
+// keeping a location per uniform. every uniform also keeps a shadow of the last value
+// sent and Set skips the glUniform call when the value hasn't changed; constant values
+// (materials, projection, lookup tables) then reach the driver once per program
+//
+// members of uniform blocks are fed by buffers, not Set; the shared Frame block is
+// bound to its fixed binding here (see FrameUniforms.h)
+//
+// Set works on the currently bound program, like glUniform. a value of the wrong size
+// for the uniform's reflected type, or a name the program doesn't use, is ignored.
+// the program object is not owned (copies share it)
+class ShaderProgram
+{
+public:
+	ShaderProgram() = default;
+	// reflect a linked program (0 gives an empty program)
+	explicit ShaderProgram(GLuint linked);
+
+	GLuint program = 0;
+
+	// location of an active uniform / attribute, -1 when the program has none by that name
+	// (array uniforms answer to their plain name, "uRingColor" as well as "uRingColor[0]")
+	GLint Uniform(const char *name) const;
+	GLint Attribute(const char *name) const;
+
+	void Set(const char *name, GLint v);
+	void Set(const char *name, float v);
+	void Set(const char *name, const glm::vec3 &v);
+	void Set(const char *name, const glm::vec4 &v);
+	void Set(const char *name, const glm::mat3 &m);
+	void Set(const char *name, const glm::mat4 &m);
+	// count elements of an array uniform (count <= its size), floats packed per element
+	void Set(const char *name, const float *v, int count);
+
+	// forget the shadow values, e.g. after uniforms were changed through raw gl calls
+	void Invalidate();
+
+private:
+	struct Slot
+	{
+		std::string name; // empty = free table slot
+		uint32_t hash = 0;
+		GLint location = -1;
+		GLenum type = 0;
+		GLint size = 0;				 // array elements (1 for plain uniforms)
+		uint32_t components = 0; // 32-bit words per element (0 = type Set can't upload)
+		bool integer = false;		 // int, bool and sampler uniforms
+		uint32_t offset = 0;		 // first shadow word
+		uint32_t known = 0;			 // leading shadow words that hold what the program has
+	};
+
+	// open addressing with linear probing over a power of two table
+	static void Insert(std::vector<Slot> &table, const Slot &slot);
+	static int Find(const std::vector<Slot> &table, const char *name);
+
+	// upload count elements of elementWords words each unless the shadow already has them
+	// (elementWords 0 takes the uniform's own element size)
+	void Store(const char *name, const void *words, uint32_t elementWords, int count, bool integer);
+
+	std::vector<Slot> uniforms;
+	std::vector<Slot> attributes;
+	std::vector<uint32_t> shadow; // last values sent, as raw 32-bit words
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// hot reload for shader programs: watches a shader directory (inotify on linux, file
+// times elsewhere) and rebuilds every program whose sources change while the game runs
+// builds are only issued from Poll and their status is checked on later frames, so the
+// driver compiles in the background (KHR_parallel_shader_compile) instead of stalling one;
+// a program is swapped in only once it has linked, a broken edit keeps the running one
+//
+// without the extension there is no way to ask whether a build is done: the status is
+// read one frame after the build starts and that read blocks until the compile and link
+// finish, so each rebuilt program stalls a frame
+class ShaderReloader
+{
+public:
+	// called with the newly linked program just before the old one is deleted:
+	// store it, look up uniform locations and upload any constant uniforms again
+	typedef std::function<void(GLuint program)> SwapFn;
+
+	explicit ShaderReloader(const std::string &dir);
+	~ShaderReloader();
+
+	ShaderReloader(const ShaderReloader &) = delete;
+	ShaderReloader &operator=(const ShaderReloader &) = delete;
+
+	// rebuild the program made from dir + vsFile / fsFile when either file changes
+	// program is the live one (0 if it failed to build, a fixed file then swaps in)
+	// defines are injected into both sources for shader variants (see InjectDefines)
+	void Watch(const std::string &vsFile, const std::string &fsFile, GLuint program, SwapFn onSwap,
+						 const std::string &defines = std::string());
+
+	// once per frame on the gl thread: picks up changes, starts builds and swaps in the
+	// programs that have finished linking (never waits on the compiler with parallel
+	// compile, blocks on a build still running without it)
+	// returns true when a program was swapped in, i.e. the next frame looks different
+	bool Poll();
+
+	// true when the driver builds programs on its own threads
+	bool ParallelCompile() const { return parallelCompile; }
+
+private:
+	struct Entry
+	{
+		std::string vsFile, fsFile;
+		std::string defines;
+		GLuint program = 0; // live program
+		uint64_t key = 0;		// program cache key of the live sources
+		SwapFn onSwap;
+		bool changed = false; // a source was written since the last build started
+
+		// build in flight (pending == 0 when idle)
+		GLuint pending = 0, pendingVs = 0, pendingFs = 0;
+		uint64_t pendingKey = 0;
+		int pendingPolls = 0; // polls since the link was issued
+
+		// last seen modification times (only without inotify)
+		std::filesystem::file_time_type vsTime, fsTime;
+	};
+
+	// both sources of e with its defines and their cache key, false when a file can't be read
+	bool Load(const Entry &e, std::string &vsSrc, std::string &fsSrc, uint64_t &key) const;
+	// mark entries whose files were written since the last call
+	void CollectChanges();
+	// start rebuilding e from the files on disk
+	void Start(Entry &e);
+	// true once the pending build should be checked: finished (parallel compile), or one
+	// frame old without it, when checking blocks until the build is done
+	bool Ready(const Entry &e) const;
+	// check the pending build and swap it in if it linked
+	void Finish(Entry &e);
+	// delete the pending build
+	void Drop(Entry &e);
+	// make program live for e (deletes the old one)
+	void Swap(Entry &e, GLuint program, uint64_t key);
+
+	std::string dir;
+	std::vector<Entry> entries;
+	bool parallelCompile = false;
+	int notifyFd = -1;		// inotify descriptor, -1 when file times are polled instead
+	unsigned pollCount = 0; // throttles the file time checks
+};
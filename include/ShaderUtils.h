@@ -1,17 +1,31 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <GL/glew.h>
 
-struct ShaderProgram
+// attribute slots every program is linked with (BeginLinkProgram), meshes feed these
+enum VertexAttrib : GLuint
 {
-  GLuint program = 0;
-  GLint locModel = -1, locView = -1, locProj = -1, locNormalMat = -1;
-  GLint locLightPos = -1, locViewPos = -1;
-  GLint locMatAmbient = -1, locMatDiffuse = -1, locMatSpecular = -1, locMatShininess = -1;
-  GLint attribPos = -1, attribNormal = -1;
+  ATTRIB_POS = 0,            // vec3 aPos
+  ATTRIB_NORMAL = 1,         // vec3 aNormal (vec2 with PACKED_NORMALS)
+  ATTRIB_INSTANCE_MODEL = 2, // mat4 aInstanceModel, takes 2 to 5
+  ATTRIB_SURFACE = 6,        // vec3 aSurface, wave surface flags (wave.vert)
 };
 
 bool LoadTextFile(const std::string &path, std::string &out);
-GLuint CompileShaderFromFile(GLenum type, const std::string &path, std::string *err = nullptr);
-bool LinkProgram(GLuint vs, GLuint fs, GLuint &outProgram, std::string *err = nullptr);
-ShaderProgram MakeGroundProgram(const std::string &vsPath, const std::string &fsPath, std::string *err = nullptr);
+
+// shaders are looked up by file name ("scene.vert"): from the sources embedded at build
+// time (EmbeddedShaders.h), or from dir when an override directory is set (development,
+// hot reload); hash gets the source's ShaderSourceHash for program cache keys
+void SetShaderDir(const std::string &dir);
+const std::string &ShaderDir(); // "" when only the embedded sources are used
+bool LoadShaderSource(const std::string &name, std::string &out, uint64_t *hash = nullptr);
+std::string InjectDefines(const std::string &src, const std::string &defines);
+
+// split compile / link: Begin* only issues the gl calls, Finish* queries the status
+// (and so waits for the driver); drivers with KHR_parallel_shader_compile build in between
+GLuint BeginCompileShader(GLenum type, const std::string &src);
+bool FinishCompileShader(GLuint shader, const std::string &name, std::string *err = nullptr);
+GLuint BeginLinkProgram(GLuint vs, GLuint fs);
+bool FinishLinkProgram(GLuint &program, std::string *err = nullptr);
+bool EnableParallelShaderCompile();
@@ -0,0 +1,59 @@
+#pragma once
+#include "ShaderProgram.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobPool;
+class ShaderReloader;
+
+// feature bits of the scene shader (data/shaders/scene.vert / scene.frag, and wave.vert
+// with scene.frag), each one turns on the #define of the same position in SCENE_FEATURE_DEFINES
+enum SceneFeature : uint32_t
+{
+	SCENE_BLINN = 1u << 0,					// blinn-phong specular instead of phong
+	SCENE_FOG = 1u << 1,						// exponential distance fog (Frame block uFog)
+	SCENE_INSTANCED = 1u << 2,			// model matrix from the per-instance aInstanceModel attribute
+	SCENE_PACKED_NORMALS = 1u << 3, // octahedral normals in two normalized components
+	SCENE_TARGET = 1u << 4,					// analytic target rings on a disc (uRingRadius / uRingColor)
+};
+static const int SCENE_FEATURE_COUNT = 5;
+static const char *const SCENE_FEATURE_DEFINES[SCENE_FEATURE_COUNT] = {"BLINN", "FOG", "INSTANCED",
+																																			 "PACKED_NORMALS", "TARGET"};
+
+// every #define permutation of one vertex + fragment source pair, indexed by feature mask
+// Build keys every variant from the source hashes and restores what the program binary
+// cache has, assembles the remaining variant sources on the job pool, issues every
+// compile and link before reading any status (a driver with KHR_parallel_shader_compile
+// then builds them all at once on its own threads) and only then collects the results
+class ShaderVariants
+{
+public:
+	// shaders by name (see LoadShaderSource), defines[i] is the macro for feature bit i
+	// (featureCount <= 16)
+	ShaderVariants(const std::string &vsName, const std::string &fsName, const char *const *defines, int featureCount);
+
+	// build the variants in masks (all 1 << featureCount of them when empty)
+	// returns how many failed, their errors are printed
+	int Build(JobPool &jobs, std::vector<uint32_t> masks = std::vector<uint32_t>());
+
+	// variant for a feature mask, empty (program 0) when it wasn't built or failed
+	ShaderProgram &Get(uint32_t mask) { return programs[mask & (programs.size() - 1)]; }
+
+	// "#define NAME 1" lines for a mask, as injected into the sources
+	std::string Defines(uint32_t mask) const;
+
+	// register every variant Build was asked for with the hot reloader (watching the shader
+	// override dir), failed ones too so a fixed source swaps them in
+	void Watch(ShaderReloader &reloader);
+
+	int Compiled() const { return compiled; } // variants built from source by the last Build
+	int Cached() const { return cached; }			// variants restored from the binary cache
+
+private:
+	std::string vsName, fsName;
+	std::vector<std::string> macros;
+	std::vector<ShaderProgram> programs; // 1 << featureCount entries
+	std::vector<uint8_t> requested;			 // 1 when Build was asked for the mask
+	int compiled = 0, cached = 0;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "QuadMesh.h"
+#include "RenderQueue.h"
+#include <vector>
+
+// unit solid (sphere, cone, box or quad) kept in a static vbo/ibo and drawn through the
+// aPos / aNormal slots of the scene shader; size and placement come from the model
+// matrix, normals stay correct under non-uniform scale through the normal matrix
+class ShapeMesh
+{
+private:
+	std::vector<MeshVertex> vertices;	 // cpu copy: interleaved vertex data
+	std::vector<unsigned int> indices; // triangle list
+
+	// opengl buffer object ids: 0=vertices, 1=ebo
+	GLuint vbos[2] = {0, 0};
+	GLuint vao = 0; // both buffers recorded for the render queue (0 without vertex array objects)
+
+	// create the buffers from vertices/indices
+	void Upload();
+
+public:
+	// sphere of radius 1 around the origin (as glutSolidSphere)
+	void InitSphere(int slices, int stacks);
+	// cone with base radius 1 at z = 0 and apex at z = 1, base capped (as glutSolidCone)
+	void InitCone(int slices, int stacks);
+	// cube from -0.5 to 0.5 on every axis
+	void InitBox();
+	// square from -1 to 1 in x and y facing +z
+	void InitQuad();
+
+	// vertex arrays for the render queue (aPos / aNormal)
+	RenderMesh Layout() const;
+
+	int NumTriangles() const { return (int)indices.size() / 3; }
+};
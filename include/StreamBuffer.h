@@ -0,0 +1,55 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+// scratch memory for data the cpu rewrites every frame (streamed vertices, uniform blocks),
+// suballocated from one gl buffer that can be bound to any target
+//
+// with ARB_buffer_storage the buffer is mapped once, persistently and coherently, and split
+// into kFrames regions: frame n writes region n % kFrames and EndFrame puts a fence behind
+// its commands, which is waited on (normally long signalled) before that region is written
+// again. without it every frame orphans the buffer (glBufferData with no data) and Commit
+// uploads with glBufferSubData, so the driver hands out fresh storage instead of waiting on
+// draws still reading the old one
+//
+// either way data allocated in a frame stays valid until EndFrame, so it has to be written
+// again every frame it is drawn
+class StreamBuffer
+{
+public:
+	StreamBuffer() = default;
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer &) = delete;
+	StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+	// true when the driver can map buffers persistently (checked once a context exists)
+	static bool PersistentSupported();
+
+	// create the buffer, a frame may allocate up to bytesPerFrame
+	void Init(size_t bytesPerFrame);
+
+	// reserve bytes at an offset into Buffer() aligned to align and return where to write
+	// them, nullptr when this frame's space is used up; Commit once written
+	void *Alloc(size_t bytes, size_t align, GLintptr &offset);
+	// make bytes written at offset visible to the gpu (nothing to do when mapped)
+	void Commit(GLintptr offset, size_t bytes);
+
+	// fence this frame's commands and start the next frame's allocations
+	void EndFrame();
+
+	GLuint Buffer() const { return buffer; }
+	bool Persistent() const { return mapped != nullptr; }
+
+private:
+	static const int kFrames = 3; // frames the gpu may still be reading
+
+	GLuint buffer = 0;
+	size_t frameBytes = 0;
+	int frame = 0;										// region being written (persistent)
+	size_t used = 0;									// bytes allocated this frame
+	unsigned char *mapped = nullptr;	// all regions, persistently mapped
+	GLsync fences[kFrames] = {};			// end of the last frame that wrote each region
+	std::vector<unsigned char> staging; // orphaning path: this frame's bytes before Commit
+};
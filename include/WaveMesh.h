@@ -0,0 +1,54 @@
+#pragma once
+#include "Duck.h"
+#include "RenderQueue.h"
+#include <vector>
+
+// wave vertex: rest position + normal, plus flags telling wave.vert which
+// vertices follow the animated surface
+struct WaveVertex
+{
+	glm::vec3 position; // rest position (wave at time 0)
+	glm::vec3 normal;		// rest normal
+	glm::vec3 surface;	// x: height follows the surface, y: normal follows the surface slope,
+											// z: x slides with the crests (clamped to the strip)
+};
+
+// water wave solid (top surface, front/back sides, bottom and end caps) kept in a
+// vbo/ibo and only rebuilt when the wave shape or error tolerance changes (time
+// animates on the gpu). surface samples are placed adaptively: dense where the
+// curvature is high, sparse where the wave is nearly straight. a moving wave keeps
+// that fit by sliding the samples along with its crests (see Sample)
+class WaveMesh
+{
+private:
+	static constexpr float kMinError = 1e-4f; // tightest tolerance accepted (world units)
+
+	WaveParams builtFor;		// parameters of the geometry in the buffers
+	float builtError = 0.0f; // quantized tolerance of the geometry in the buffers
+	bool built = false;			// true once the buffers hold geometry
+
+	std::vector<WaveVertex> vertices;	 // cpu copy: interleaved vertex data
+	std::vector<unsigned int> indices; // triangle list
+
+	// opengl buffer object ids: 0=vertices, 1=ebo
+	GLuint vbos[2] = {0, 0};
+	GLuint vao = 0; // both buffers recorded for the render queue (rebuilds keep the buffers)
+
+	// x positions of surface samples keeping the outline within maxError
+	void Sample(const WaveParams &wave, float maxError, std::vector<float> &xs) const;
+	// fill vertices/indices for wave
+	void Build(const WaveParams &wave, float maxError);
+
+public:
+	// rebuild and upload when wave or the tolerance (rounded to a power of sqrt(2))
+	// differs from the built geometry; maxError is the allowed distance in world
+	// units between the drawn outline and the true surface
+	// returns true when a rebuild happened
+	bool Update(const WaveParams &wave, float maxError);
+
+	// vertex arrays for the render queue (aPos / aNormal / aSurface, drawn with wave.vert)
+	RenderMesh Layout() const;
+
+	int NumTriangles() const { return (int)indices.size() / 3; }
+	int NumSurfaceSamples() const { return built ? (int)(vertices.size() - 12) / 6 : 0; }
+};
@@ -1,46 +1,108 @@
 #include "Duck.h"
 #include "ShaderUtils.h"
+#include "ProgramCache.h"
+#include "DuckSim.h"
+#include "JobPool.h"
+#include "Impostor.h"
+#include "WaveMesh.h"
+#include "Ocean.h"
+#include "OceanMesh.h"
+#include "ShaderReload.h"
+#include "FrameUniforms.h"
+#include "ShaderVariants.h"
+#include "ShapeMesh.h"
+#include "RenderQueue.h"
+#include "Frustum.h"
+#include "OcclusionQueries.h"
+#include "StreamBuffer.h"
+#include "MatrixStack.h"
+#include "FramePacer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 const int vWidth = 650;  // viewport width
 const int vHeight = 500; // viewport height
 
-// camera and state
-struct DuckPosition
-{
-  float x = -6.0f; // duck x position
-  float y = 1.0f;  // duck y position
-  float z = 0.0f;  // duck z position
-};
-DuckPosition duckPos;
+// duck simulation state (struct-of-arrays, see DuckSim.h)
+DuckBatch gDucks;       // every duck in the scene
+DuckSimParams gDuckSim; // shared speeds and wave edges
+size_t duckCount = 1;   // number of ducks (--ducks N)
 
-// animation state for duck movement
-enum DuckState
-{
-  FORWARD,
-  TURN_AT_RIGHT,
-  BACKWARD,
-  TURN_AT_LEFT
-};
-DuckState duckState = FORWARD;
+// worker threads for the duck update
+JobPool *gJobs = nullptr; // created in main
+unsigned threadCount = 0; // --threads N (0 = one per core)
+const size_t SIM_CHUNK = 4096; // ducks per job chunk (fixed so results never depend on thread count)
+const float TICK_SECONDS = 1.0f / 60.0f; // simulated time per animation tick (ticks follow real time at any
+                                         // frame rate; one per refresh at 60 Hz, so vsync never doubles up)
+const int MAX_TICKS_PER_FRAME = 4; // catch-up limit after a stall or an idle stretch
 
 // rotation direction multiplier (keeps spin consistent)
 const int ROT_DIR = -1;
 
-// angles and speeds
-float duckSpinDeg = 0.0f;      // current spin angle while turning
-const float moveSpeed = 0.06f; // forward/backward step per frame
-const float spinSpeed = 4.0f;  // degrees per frame during turning
+// far gallery ducks are drawn as billboards sampling a pre-rendered atlas
+ImpostorAtlas gDuckImpostor;              // baked at startup for galleries
+std::vector<ImpostorQuad> gImpostorQuads; // per-frame billboards
+const float IMPOSTOR_FADE_START = 40.0f;  // distance where the crossfade begins
+const float IMPOSTOR_FADE_END = 46.0f;    // distance beyond which only the billboard is drawn
 
-// turn geometry (computed when duck reaches edge)
-float turnRadius = 0.0f;
-float turnPivotX = 0.0f;
-float turnPivotY = 0.0f;
+// duck bounding sphere in object space (covers body, head, beak, tail and target)
+const glm::vec3 DUCK_BOUND_CENTER(0.0f, 0.6f, 0.0f);
+const float DUCK_BOUND_RADIUS = 2.1f;
+
+// duck parts placed in duck space, composed once by buildDuckParts; drawing a duck
+// then costs one matrix product per part (model * part)
+enum DuckPart
+{
+  DUCK_BODY,
+  DUCK_NECK,
+  DUCK_HEAD,
+  DUCK_EYE_LEFT,
+  DUCK_EYE_RIGHT,
+  DUCK_BEAK,
+  DUCK_TAIL,
+  DUCK_TARGET,
+  DUCK_PART_COUNT
+};
+static glm::mat4 gDuckParts[DUCK_PART_COUNT];
 
-QuadMesh *groundMesh = nullptr; // ground mesh for terrain
+QuadMesh *groundMesh = nullptr; // one ground chunk, drawn at every chunk position
 QuadMesh *panelMesh = nullptr;  // panel mesh for UI elements
 int meshSize = 16;              // tessellation for meshes
+const int GROUND_CHUNKS = 4;    // chunks per side of the 32 x 32 ground (culled one by one)
+const float GROUND_SIZE = 32.0f;
+const float GROUND_Y = -5.0f;
+// placement and world bounds of each ground chunk (fixed, computed in initOpenGL)
+struct GroundChunk
+{
+  glm::mat4 model;
+  glm::vec3 lo, hi;
+};
+static std::vector<GroundChunk> gGroundChunks;
+// booth boxes in world space with their bounds and color (fixed, see buildBoothParts)
+struct BoothPart
+{
+  glm::mat4 model;
+  glm::vec3 lo, hi;
+  glm::vec3 color;
+  bool base; // hidden with space
+};
+static std::vector<BoothPart> gBoothParts;
+static glm::mat4 gWaterModel; // water solid on the base top
+WaveMesh gWaveMesh;              // water wave solid (rebuilt when gWave changes)
+float waveErrorPixels = 0.5f;    // wave outline error budget on screen (--wave-error PX)
+float gWaveTolerance = 0.01f;    // same budget in world units at the current camera distance
+int viewportHeight = vHeight;    // kept by reshape for screen-space error
+const float CAMERA_FOV_DEG = 60.0f; // vertical field of view
+
+// optional spectral ocean replacing the sine wave (--ocean N)
+int oceanSize = 0;       // fft size per side, 0 keeps the sine wave
+Ocean *gOcean = nullptr; // created once scene parameters are known
+OceanMesh gOceanMesh;    // water surface resampled every tick, streamed every frame
+float oceanTime = 0.0f;  // seconds, wraps at the ocean loop period
 
 // camera parameters for orbiting
 float cameraZoom = 22.0f; // distance from scene center
@@ -60,20 +122,111 @@ bool rightMouseDown = false; // right button drag state
 // visibility toggle
 bool showBase = true; // show booth base by default
 
+// frames are drawn on demand: the timer ticks (and redraws) only while the water and ducks
+// move, and input redraws through markDirty; a paused, untouched scene draws nothing
+bool animationPaused = false;      // 'p' freezes the water and ducks (--paused starts frozen)
+const int IDLE_POLL_MS = 100;      // shader reload polling while idle (--shaders)
+const int SETTLE_FRAMES = 2;       // frames drawn after a change so occlusion answers catch up
+static bool gTimerRunning = false; // animationHandler is scheduled
+static int gSettleFrames = 0;
+static void markDirty(); // redraw now and tick until settled (defined after keyboard)
+static std::chrono::steady_clock::time_point gLastTick; // when animationHandler last ran
+static double gTickTime = 0.0; // real time not yet simulated (less than a tick after each call)
+
+// frames are paced at the swap (see FramePacer.h), not by the timer, which asks for the next
+// frame as soon as one is drawn
+static FramePacer gPacer;
+PresentMode presentMode = PRESENT_VSYNC; // --present vsync | adaptive | uncapped | fixed
+double fixedFps = 60.0;                  // --fps N: rate of the fixed mode (and the vsync fallback)
+
 int lastMouseX = 0; // last mouse x used for dragging
 int lastMouseY = 0; // last mouse y used for dragging
 
-// flip animation for duck's target/face
-bool isFlipping = false;      // currently flipping down?
-bool isFlipped = false;       // fully flipped down?
-float flipAngle = 0.0f;       // current tilt around x axis (degrees)
-const float flipSpeed = 5.0f; // degrees per frame for flip
-
 // global scene parameter structs (defined in headers)
 WaveParams gWave;
 BoothLayout gBooth;
 
-static ShaderProgram gGroundProg; // shader program for ground
+// every solid is drawn by the scene shader (one light, phong materials), picked by
+// feature mask each frame; programs reflect their uniforms and Set skips values they
+// already have, so constant materials and ring tables reach the driver once
+static ShaderVariants gSceneShader("scene.vert", "scene.frag", SCENE_FEATURE_DEFINES, SCENE_FEATURE_COUNT);
+// water surface animated on the gpu (wave.vert), shaded by the same scene.frag
+static ShaderVariants gWaveShader("wave.vert", "scene.frag", SCENE_FEATURE_DEFINES, SCENE_FEATURE_COUNT);
+uint32_t sceneFeatures = 0;            // SceneFeature bits for the scene ('b' blinn, 'g' fog)
+const float FOG_DENSITY = 0.02f;       // GL_EXP2 density of the fog variants and the impostor fog
+static FrameUniforms gFrameUniforms; // view, projection and light shared by every program
+static StreamBuffer gStream;         // per-frame data: the frame block and the ocean vertices
+const size_t STREAM_FRAME_BYTES = 1 << 20; // stream space one frame may use
+const glm::vec4 LIGHT_POS(-4.0f, 8.0f, 8.0f, 1.0f); // world space
+
+// unit solids the booth and ducks are built from (scaled by their model matrices)
+static ShapeMesh gSphereMesh, gEyeMesh, gConeMesh, gBoxMesh, gDiscMesh;
+// colored parts keep the old fixed-function look: ambient 0.2 (model) + 0.4 (light), no specular
+const float MATTE_AMBIENT = 0.6f;
+
+// every draw of a frame is submitted to one queue, sorted by state before it runs
+static RenderQueue gQueue;
+// queue ids of the programs, meshes and duck materials shared by a frame (see beginQueue)
+struct SceneIds
+{
+  uint32_t scene, target, wave;          // programs
+  uint32_t sphere, eye, cone, box, disc; // unit solids
+  uint32_t yellow, black, orange, white; // duck materials
+};
+static SceneIds gIds;
+bool showStats = false; // --stats: print queue draws and state changes once a second
+
+// this frame's view volume; booth parts, ground chunks and ducks outside it are not submitted
+static Frustum gFrustum;
+// objects tested against gFrustum this frame and how many were dropped (--stats)
+struct CullCounts
+{
+  int tested = 0, culled = 0;
+};
+static CullCounts gCullBooth, gCullGround, gCullDucks;
+
+// ducks in view and close enough for geometry are also tested for being hidden behind
+// the booth: last frame's occlusion query decides whether they draw (see OcclusionQueries.h)
+static OcclusionQueries gOcclusion;
+bool occlusionCulling = true; // --no-occlusion turns it off
+static int gOccludedDucks = 0; // ducks skipped this frame because their proxy drew nothing
+
+// ducks are culled and recorded on the job pool, one render list per chunk of ducks;
+// the gl thread appends the chunks in order, so the frame is the same for any thread count
+struct DuckChunk
+{
+  RenderQueue::List list;
+  std::vector<ImpostorQuad> quads;
+  CullCounts cull;
+  int occluded = 0;
+};
+static std::vector<DuckChunk> gDuckChunks;
+const size_t DRAW_CHUNK = 256; // ducks per recording job
+
+// shaders are built into the executable; --shaders DIR reads them from DIR instead and
+// rebuilds the programs above whenever a file there changes
+static ShaderReloader *gShaderReload = nullptr;
+
+// target rings from the outside in (radii match the old 4/3/2 spheres scaled by 0.22)
+const TargetRing TARGET_RINGS[TARGET_RING_COUNT] = {
+    {0.88f, 1, {1.0f, 0.0f, 0.0f}},
+    {0.66f, 2, {1.0f, 1.0f, 1.0f}},
+    {0.44f, 3, {1.0f, 0.0f, 0.0f}},
+};
+
+// score for a hit r units from the target center: innermost ring that contains it
+// (0 outside every ring). the game has no shooting yet, this is kept with the table
+// for when hits are scored
+[[maybe_unused]] static int targetScoreAt(float r)
+{
+  int score = 0;
+  for (int i = 0; i < TARGET_RING_COUNT; i++)
+    if (r <= TARGET_RINGS[i].radius)
+      score = TARGET_RINGS[i].score;
+  return score;
+}
+const float TARGET_CENTER_Y = -0.18f; // target center on the duck's side
+const float TARGET_Z = 1.40f;         // disc plane, just outside the body
 
 // mouse button handler for camera orbit and zoom
 void mouseButton(int button, int state, int x, int y)
@@ -89,7 +242,7 @@ void mouseButton(int button, int state, int x, int y)
       cameraZoom = CAMERA_ZOOM_MIN;
     if (cameraZoom > CAMERA_ZOOM_MAX)
       cameraZoom = CAMERA_ZOOM_MAX;
-    glutPostRedisplay();
+    markDirty();
   }
 }
 
@@ -116,7 +269,7 @@ void mouseMotion(int x, int y)
 
     lastMouseX = x;
     lastMouseY = y;
-    glutPostRedisplay();
+    markDirty();
   }
   else if (rightMouseDown)
   {
@@ -127,7 +280,7 @@ void mouseMotion(int x, int y)
     if (cameraZoom > CAMERA_ZOOM_MAX)
       cameraZoom = CAMERA_ZOOM_MAX;
     lastMouseY = y;
-    glutPostRedisplay();
+    markDirty();
   }
 }
 
@@ -170,10 +323,164 @@ void setupSceneParams()
   gWave.baseY = -0.001f;
   gWave.x0 = -gWave.width * 0.5f; // left bound of wave region
   gWave.x1 = gWave.width * 0.5f;  // right bound of wave region
+  gWave.speed = 0.25f;            // cycles per second the waves travel
+
+  // duck simulation follows the wave edges
+  gDuckSim.turnRadius = gWave.amp * 2.4f;
+  gDuckSim.x0 = gWave.x0;
+  gDuckSim.x1 = gWave.x1;
+}
+
+// build the ocean for the booth water and let ducks ride it
+static void createOcean()
+{
+  if (!oceanSize || gOcean)
+    return;
+  // one 16 unit tile repeats across the booth, light wind slightly off the x axis
+  gOcean = new Ocean(oceanSize, 16.0f, 6.0f, 1.0f, 0.3f, gWave.amp * 0.5f, gWave.lift);
+  gDuckSim.ocean = gOcean;
+}
+
+// advance the ocean one tick (fft runs on the job pool)
+static void stepOcean()
+{
+  if (!gOcean)
+    return;
+  oceanTime = std::fmod(oceanTime + TICK_SECONDS, gOcean->LoopPeriod());
+  gOcean->Update(oceanTime, *gJobs);
+}
+
+// step every duck once, split across the job pool
+// ParallelFor returns only when every chunk is done, so rendering sees a finished tick
+static void stepDucks()
+{
+  gJobs->ParallelFor(gDucks.size(), SIM_CHUNK, [](size_t begin, size_t end)
+                     { StepDuckBatch(gDucks, gDuckSim, begin, end); });
+}
+
+// true when two batches hold bit-identical state
+static bool sameDuckState(const DuckBatch &a, const DuckBatch &b)
+{
+  return a.x == b.x && a.y == b.y && a.spinDeg == b.spinDeg && a.pivotX == b.pivotX &&
+         a.pivotY == b.pivotY && a.flipAngle == b.flipAngle && a.state == b.state &&
+         a.flipping == b.flipping && a.flipped == b.flipped;
+}
+
+// time the duck simulation without opening a window (--bench)
+static void runBenchmark()
+{
+  const int ticks = 1000;
+  setupSceneParams();
+  createOcean();
+  stepOcean();
+
+  // single-threaded reference run
+  DuckBatch reference;
+  InitDuckBatch(reference, duckCount, gDuckSim, -6.0f);
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < ticks; i++)
+    StepDuckBatch(reference, gDuckSim, 0, reference.size());
+  auto t1 = std::chrono::steady_clock::now();
+
+  // same ticks on the job pool
+  InitDuckBatch(gDucks, duckCount, gDuckSim, -6.0f);
+  auto t2 = std::chrono::steady_clock::now();
+  for (int i = 0; i < ticks; i++)
+    stepDucks();
+  auto t3 = std::chrono::steady_clock::now();
+
+  double ms1 = std::chrono::duration<double, std::milli>(t1 - t0).count() / ticks;
+  double msN = std::chrono::duration<double, std::milli>(t3 - t2).count() / ticks;
+  fprintf(stdout, "duck sim: %zu ducks, 1 thread %.4f ms/tick, %u threads %.4f ms/tick\n",
+          gDucks.size(), ms1, gJobs->ThreadCount(), msN);
+  fprintf(stdout, "duck sim: results %s across thread counts\n",
+          sameDuckState(reference, gDucks) ? "identical" : "DIFFER");
+
+  // ocean fft per tick, single-threaded and on the pool
+  if (gOcean)
+  {
+    const int oceanTicks = 100;
+    JobPool single(1);
+    auto o0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < oceanTicks; i++)
+      gOcean->Update(i * TICK_SECONDS, single);
+    auto o1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < oceanTicks; i++)
+      gOcean->Update(i * TICK_SECONDS, *gJobs);
+    auto o2 = std::chrono::steady_clock::now();
+
+    double os1 = std::chrono::duration<double, std::milli>(o1 - o0).count() / oceanTicks;
+    double osN = std::chrono::duration<double, std::milli>(o2 - o1).count() / oceanTicks;
+    fprintf(stdout, "ocean: %dx%d fft, 1 thread %.4f ms/tick, %u threads %.4f ms/tick\n",
+            gOcean->Size(), gOcean->Size(), os1, gJobs->ThreadCount(), osN);
+  }
 }
 
 int main(int argc, char **argv)
 {
+  // command line options: --ducks N (gallery size), --threads N (simulation threads),
+  // --ocean N (fft ocean of N x N, 64 to 512), --wave-error PX (wave tessellation
+  // error budget in pixels), --shaders DIR (load and hot reload shaders from DIR),
+  // --cache DIR (program binary cache directory, default "cache" in the working directory),
+  // --stats (print render queue counts), --no-occlusion (draw ducks hidden by the booth),
+  // --paused (start with the animation frozen), --present MODE (vsync, adaptive, uncapped or
+  // fixed), --fps N (fixed mode rate), --bench (time simulation and exit)
+  bool bench = false, ducksGiven = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--ducks") && i + 1 < argc)
+      duckCount = (size_t)strtoul(argv[++i], nullptr, 10), ducksGiven = true;
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      threadCount = (unsigned)strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--wave-error") && i + 1 < argc)
+      waveErrorPixels = (float)strtod(argv[++i], nullptr);
+    else if (!strcmp(argv[i], "--ocean") && i + 1 < argc)
+      oceanSize = (int)strtol(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--shaders") && i + 1 < argc)
+      SetShaderDir(argv[++i]);
+    else if (!strcmp(argv[i], "--cache") && i + 1 < argc)
+      SetProgramCacheDir(argv[++i]);
+    else if (!strcmp(argv[i], "--stats"))
+      showStats = true;
+    else if (!strcmp(argv[i], "--no-occlusion"))
+      occlusionCulling = false;
+    else if (!strcmp(argv[i], "--paused"))
+      animationPaused = true;
+    else if (!strcmp(argv[i], "--present") && i + 1 < argc)
+    {
+      if (!FramePacer::ParseMode(argv[++i], presentMode))
+      {
+        fprintf(stderr, "--present must be vsync, adaptive, uncapped or fixed\n");
+        return 1;
+      }
+    }
+    else if (!strcmp(argv[i], "--fps") && i + 1 < argc)
+      fixedFps = strtod(argv[++i], nullptr);
+    else if (!strcmp(argv[i], "--bench"))
+      bench = true;
+  }
+
+  if (!(fixedFps >= 1.0))
+  {
+    fprintf(stderr, "--fps must be at least 1\n");
+    return 1;
+  }
+  if (oceanSize && !Ocean::ValidSize(oceanSize))
+  {
+    fprintf(stderr, "--ocean size must be a power of two from 64 to 512\n");
+    return 1;
+  }
+
+  gJobs = new JobPool(threadCount);
+
+  if (bench)
+  {
+    if (!ducksGiven)
+      duckCount = 100000; // default benchmark population
+    runBenchmark();
+    return 0;
+  }
+
   glutInit(&argc, argv);
   glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
   glutInitWindowSize(vWidth, vHeight);
@@ -188,65 +495,119 @@ int main(int argc, char **argv)
   }
 
   initOpenGL(vWidth, vHeight);
+  gPacer.Init(presentMode, fixedFps, showStats);
 
   glutDisplayFunc(display);
   glutReshapeFunc(reshape);
   glutKeyboardFunc(keyboard);
-  glutTimerFunc(16, animationHandler, 0);
+  gLastTick = std::chrono::steady_clock::now();
+  markDirty();
 
   glutMainLoop();
   return 0;
 }
 
+static void bakeDuck(const glm::mat4 &view, const glm::mat4 &proj);
+static void beginQueue(RenderQueue &queue, const glm::vec3 &eye, uint32_t features);
+static void printQueueStats();
+static bool inView(CullCounts &counts, bool visible);
+static bool testOcclusion(RenderQueue::List &list, size_t i, const glm::vec3 &center, const glm::vec3 &eye);
+static void recordDucks(DuckChunk &chunk, size_t begin, size_t end, const glm::vec3 &eye);
+static void buildDuckParts();
+static void buildBoothParts();
+
 // initialize OpenGL state and create meshes/shaders
+// lighting is done by the scene shader, no fixed-function light or material state is used
 void initOpenGL(int w, int h)
 {
-  GLfloat light_pos[] = {-4.0f, 8.0f, 8.0f, 1.0f};
-  GLfloat light_diffuse[] = {1.0f, 1.0f, 1.0f, 1.0f};
-  GLfloat light_specular[] = {1.0f, 1.0f, 1.0f, 1.0f};
-  GLfloat light_ambient[] = {0.4f, 0.4f, 0.4f, 1.0f};
-
-  // setup simple lighting
-  glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
-  glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
-  glLightfv(GL_LIGHT0, GL_SPECULAR, light_specular);
-  glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
-
-  glEnable(GL_LIGHTING);
-  glEnable(GL_LIGHT0);
-  glEnable(GL_COLOR_MATERIAL);
-
-  glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
   glEnable(GL_DEPTH_TEST);
-  glShadeModel(GL_SMOOTH);
   glClearColor(0.4f, 0.4f, 0.4f, 1.0f);
-  glEnable(GL_NORMALIZE);
 
-  // create ground mesh positioned to left of origin
-  glm::vec3 origin(-16.0f, 0.0f, 16.0f);
+  // ground: one chunk mesh centered on its origin, placed GROUND_CHUNKS^2 times so the
+  // chunks out of view can be skipped
+  const int chunkQuads = meshSize / GROUND_CHUNKS;
+  const float chunkSize = GROUND_SIZE / GROUND_CHUNKS;
+  glm::vec3 origin(-chunkSize * 0.5f, 0.0f, chunkSize * 0.5f);
   glm::vec3 dir1(1.0f, 0.0f, 0.0f);
   glm::vec3 dir2(0.0f, 0.0f, -1.0f);
-  groundMesh = new QuadMesh(meshSize, 32.0f);
-  groundMesh->InitMesh(meshSize, origin, 32.0, 32.0, dir1, dir2);
+  groundMesh = new QuadMesh(chunkQuads, chunkSize);
+  groundMesh->InitMesh(chunkQuads, origin, chunkSize, chunkSize, dir1, dir2);
+  for (int cz = 0; cz < GROUND_CHUNKS; cz++)
+  {
+    for (int cx = 0; cx < GROUND_CHUNKS; cx++)
+    {
+      const glm::vec3 center(-GROUND_SIZE * 0.5f + chunkSize * (cx + 0.5f), GROUND_Y, -GROUND_SIZE * 0.5f + chunkSize * (cz + 0.5f));
+      const glm::vec3 half(chunkSize * 0.5f, 0.0f, chunkSize * 0.5f);
+      gGroundChunks.push_back({glm::translate(glm::mat4(1.0f), center), center - half, center + half});
+    }
+  }
 
   panelMesh = QuadMesh::MakeUnitPanel(); // simple unit panel mesh
+  gSphereMesh.InitSphere(30, 30);         // duck body and head
+  gEyeMesh.InitSphere(16, 16);
+  gConeMesh.InitCone(20, 12);             // neck, beak and tail
+  gBoxMesh.InitBox();                     // booth base, pillars and beam
+  gDiscMesh.InitQuad();                   // target disc (rings are shaded per fragment)
   setupSceneParams();                    // compute scene constants
+  buildDuckParts();
+  buildBoothParts();
+  gStream.Init(STREAM_FRAME_BYTES);
+  fprintf(stdout, "Stream buffer: %s.\n", gStream.Persistent() ? "persistent mapping" : "orphaning");
+  createOcean();
+  InitDuckBatch(gDucks, duckCount, gDuckSim, -6.0f);
+  if (gOcean)
+  {
+    const float halfT = gWave.thickZ * 0.5f;
+    stepOcean();
+    gOceanMesh.Init(gWave.x0, gWave.x1, -halfT, halfT, gWave.baseY);
+    gOceanMesh.Update(*gOcean);
+  }
 
-  // load ground shader program
-  std::string base = "data/shaders/";
-  std::string err;
-  gGroundProg = MakeGroundProgram(base + "ground.vert", base + "ground.frag", &err);
-
-  if (!gGroundProg.program)
+  // build every scene shader variant up front, so switching features never compiles
+  // (every program goes through the on-disk binary cache, see ProgramCache.h)
+  const auto shaderStart = std::chrono::steady_clock::now();
+  const int failed = gSceneShader.Build(*gJobs);
+  fprintf(stdout, "Scene shader: %d variants (%d compiled, %d from cache, %d failed).\n",
+          1 << SCENE_FEATURE_COUNT, gSceneShader.Compiled(), gSceneShader.Cached(), failed);
+  if (failed)
+    fprintf(stderr, "Scene shader variants failed, their geometry will not draw.\n");
+
+  // the water only has the lighting features
+  if (gWaveShader.Build(*gJobs, {0, SCENE_BLINN, SCENE_FOG, SCENE_BLINN | SCENE_FOG}))
   {
-    fprintf(stderr, "Shader program failed: %s\n", err.c_str());
+    // the wave holds still while its program is missing, until a reload repairs it
+    // (see animationHandler)
+    fprintf(stderr, "Wave shader variants failed, the water will not draw.\n");
   }
-  else
+
+  // ground vbo feeds aPos / aNormal, whose slots every program binds at link time
+  groundMesh->CreateMeshVBO(chunkQuads, ATTRIB_POS, ATTRIB_NORMAL);
+
+  // with a shader directory, edits to its files are picked up while running (see ShaderReload.h)
+  if (!ShaderDir().empty())
   {
-    fprintf(stdout, "Shader compiled and linked successfully.\n");
-    // create vbo for ground if shader ready
-    groundMesh->CreateMeshVBO(meshSize, gGroundProg.attribPos, gGroundProg.attribNormal);
+    gShaderReload = new ShaderReloader(ShaderDir());
+    gSceneShader.Watch(*gShaderReload);
+    gWaveShader.Watch(*gShaderReload);
+    if (!gShaderReload->ParallelCompile())
+      fprintf(stdout, "No parallel shader compile: each hot reload stalls a frame while it builds.\n");
   }
+
+  const ProgramCacheStats cache = GetProgramCacheStats();
+  const double shaderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+  if (ProgramBinarySupported())
+    fprintf(stdout, "Shaders ready in %.1f ms (%d from cache, %d compiled).\n", shaderMs, cache.hits, cache.misses);
+  else
+    fprintf(stdout, "Shaders ready in %.1f ms (program binaries unsupported, no cache).\n", shaderMs);
+
+  // one occlusion query slot per duck (galleries only, a lone duck is never hidden)
+  occlusionCulling = occlusionCulling && duckCount > 1 && OcclusionQueries::Supported();
+  if (occlusionCulling)
+    gOcclusion.Resize(gDucks.size());
+
+  // galleries draw far ducks from an impostor atlas
+  if (duckCount > 1 && !BakeImpostorAtlas(gDuckImpostor, 8, 128, DUCK_BOUND_CENTER, DUCK_BOUND_RADIUS, bakeDuck))
+    fprintf(stderr, "Impostor atlas unavailable, drawing every duck as geometry.\n");
 }
 
 // glm matrix helpers for view/projection
@@ -261,9 +622,65 @@ static glm::mat4 makeProj(int w, int h)
   return glm::perspective(glm::radians(60.0f), aspect, 1.0f, 100.0f);
 }
 
+// world transform of duck i from its animation state
+static glm::mat4 duckModelMatrix(size_t i)
+{
+  glm::mat4 m(1.0f);
+  const glm::vec3 zAxis(0.0f, 0.0f, 1.0f);
+  const int32_t state = gDucks.state[i];
+  if (state == TURN_AT_RIGHT)
+  {
+    // pivot around computed turn pivot and rotate downwards
+    m = glm::translate(m, glm::vec3(gDucks.pivotX[i], gDucks.pivotY[i], gDucks.z[i]));
+    m = glm::rotate(m, glm::radians(ROT_DIR * gDucks.spinDeg[i]), zAxis);
+    m = glm::translate(m, glm::vec3(0.0f, +gDuckSim.turnRadius, 0.0f));
+  }
+  else if (state == TURN_AT_LEFT)
+  {
+    // pivot for left turn and flip 180 for facing correct way
+    m = glm::translate(m, glm::vec3(gDucks.pivotX[i], gDucks.pivotY[i], gDucks.z[i]));
+    m = glm::rotate(m, glm::radians(ROT_DIR * gDucks.spinDeg[i]), zAxis);
+    m = glm::translate(m, glm::vec3(0.0f, -gDuckSim.turnRadius, 0.0f));
+    m = glm::rotate(m, glm::pi<float>(), zAxis);
+  }
+  else
+  {
+    // normal translate when moving straight
+    m = glm::translate(m, glm::vec3(gDucks.x[i], gDucks.y[i], gDucks.z[i]));
+    if (state == BACKWARD)
+      m = glm::rotate(m, glm::pi<float>(), zAxis); // face backwards when moving left
+  }
+
+  // apply flip tilt to duck (target face animation)
+  return glm::rotate(m, glm::radians(gDucks.flipAngle[i]), glm::vec3(1.0f, 0.0f, 0.0f));
+}
+
+// world box of the sine wave: base top up to the highest crest
+static void waterBounds(glm::vec3 &lo, glm::vec3 &hi)
+{
+  const float halfT = gWave.thickZ * 0.5f;
+  lo = glm::vec3(gWave.x0, gBooth.baseTopY + gWave.baseY, -halfT);
+  hi = glm::vec3(gWave.x1, gBooth.baseTopY + gWave.lift + gWave.amp, halfT);
+}
+
+// world-space wave error that projects to waveErrorPixels at the nearest point of the water
+static float waveTolerance(const glm::vec3 &eye)
+{
+  glm::vec3 lo, hi;
+  waterBounds(lo, hi);
+  const float dist = glm::max(glm::distance(eye, glm::clamp(eye, lo, hi)), 1.0f); // near plane
+
+  const float pixelsPerUnit = (float)viewportHeight / (2.0f * std::tan(glm::radians(CAMERA_FOV_DEG) * 0.5f) * dist);
+  return waveErrorPixels / pixelsPerUnit;
+}
+
 // display callback: draws booth, duck, and ground
 void display(void)
 {
+  // swap in shaders that finished rebuilding since the last frame
+  if (gShaderReload)
+    gShaderReload->Poll();
+
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glLoadIdentity();
 
@@ -273,353 +690,446 @@ void display(void)
   float camZ = cameraZoom * glm::cos(glm::radians(cameraYaw)) * glm::cos(glm::radians(cameraPitch));
   gluLookAt(camX, camY, camZ, 0.0, 3.0, 0.0, 0.0, 1.0, 0.0);
 
+  // per-frame shader constants, written once for every program
+  FrameBlock frame;
+  frame.view = makeView(camX, camY, camZ);
+  frame.proj = makeProj(vWidth, vHeight);
+  frame.lightPos = LIGHT_POS;
+  frame.viewPos = glm::vec4(camX, camY, camZ, 1.0f);
+  frame.fog = glm::vec4(0.4f, 0.4f, 0.4f, FOG_DENSITY); // fades to the clear color
+  gFrameUniforms.Update(frame, gStream);
+
   // set mouse callbacks so dragging works when over window
   glutMouseFunc(mouseButton);
   glutMotionFunc(mouseMotion);
 
-  drawBooth(); // draw static booth and wave
-
-  // draw and transform the duck according to state
-  glPushMatrix();
-  if (duckState == TURN_AT_RIGHT)
+  // every solid goes into the queue; it draws them sorted by program, material and mesh,
+  // with the blended target discs last, back to front
+  const glm::vec3 eye(camX, camY, camZ);
+  gFrustum = MakeFrustum(frame.proj * frame.view);
+  gCullBooth = gCullGround = gCullDucks = CullCounts();
+  gOccludedDucks = 0;
+  beginQueue(gQueue, eye, sceneFeatures);
+  drawBooth(gQueue);
+
+  // ducks: culled and recorded in parallel
+  gImpostorQuads.clear();
+  if (occlusionCulling)
+    gOcclusion.Poll(); // last frame's answers, before the workers read them
+  gDuckChunks.resize((gDucks.size() + DRAW_CHUNK - 1) / DRAW_CHUNK);
+  gJobs->ParallelFor(gDucks.size(), DRAW_CHUNK, [&eye](size_t begin, size_t end)
+                     { recordDucks(gDuckChunks[begin / DRAW_CHUNK], begin, end, eye); });
+  for (DuckChunk &chunk : gDuckChunks)
   {
-    // pivot around computed turn pivot and rotate downwards
-    glTranslatef(turnPivotX, turnPivotY, duckPos.z);
-    glRotatef(ROT_DIR * duckSpinDeg, 0, 0, 1);
-    glTranslatef(0.0f, +turnRadius, 0.0f);
-  }
-  else if (duckState == TURN_AT_LEFT)
-  {
-    // pivot for left turn and flip 180 for facing correct way
-    glTranslatef(turnPivotX, turnPivotY, duckPos.z);
-    glRotatef(ROT_DIR * duckSpinDeg, 0, 0, 1);
-    glTranslatef(0.0f, -turnRadius, 0.0f);
-    glRotatef(180.0f, 0, 0, 1);
+    gQueue.Append(chunk.list);
+    gImpostorQuads.insert(gImpostorQuads.end(), chunk.quads.begin(), chunk.quads.end());
+    gCullDucks.tested += chunk.cull.tested;
+    gCullDucks.culled += chunk.cull.culled;
+    gOccludedDucks += chunk.occluded;
   }
-  else
+
+  // ground chunks
+  RenderMaterial ground;
+  ground.ambient = glm::vec3(0.12f, 0.28f, 0.12f);
+  ground.diffuse = glm::vec3(0.30f, 0.70f, 0.30f);
+  ground.specular = glm::vec3(0.12f, 0.12f, 0.12f);
+  ground.shininess = 16.0f;
+  const uint32_t groundMat = gQueue.Material(ground), groundId = gQueue.AddMesh(groundMesh->Layout());
+  for (const GroundChunk &chunk : gGroundChunks)
+    if (inView(gCullGround, BoxInFrustum(gFrustum, chunk.lo, chunk.hi)))
+      gQueue.Submit(PASS_OPAQUE, gIds.scene, groundMat, groundId, chunk.model);
+
+  gWaveTolerance = waveTolerance(eye);
+  drawWaterWave3D(gQueue);
+
+  gQueue.Execute(gFrameUniforms);
+  if (showStats)
+    printQueueStats();
+
+  // far ducks: pre-lit billboards, fogged by fixed-function fog on the same curve as FOG
+  if (sceneFeatures & SCENE_FOG)
   {
-    // normal translate when moving straight
-    glTranslatef(duckPos.x, duckPos.y, duckPos.z);
-    if (duckState == BACKWARD)
-      glRotatef(180.0f, 0, 0, 1); // face backwards when moving left
+    glEnable(GL_FOG);
+    glFogi(GL_FOG_MODE, GL_EXP2);
+    glFogf(GL_FOG_DENSITY, FOG_DENSITY);
+    glFogfv(GL_FOG_COLOR, &frame.fog[0]);
   }
+  DrawImpostors(gDuckImpostor, gImpostorQuads.data(), gImpostorQuads.size());
+  glDisable(GL_FOG);
 
-  // apply flip tilt to duck (target face animation)
-  glRotatef(flipAngle, 1, 0, 0);
+  gPacer.WaitForPresent();
+  glutSwapBuffers();
+  gPacer.Presented();
+  gStream.EndFrame();
+}
 
-  drawDuck(); // draw duck parts
-  glPopMatrix();
+// matte material of a colored part
+static RenderMaterial matte(const glm::vec3 &color)
+{
+  RenderMaterial m;
+  m.ambient = color * MATTE_AMBIENT;
+  m.diffuse = color;
+  return m;
+}
 
-  // draw ground using shader if available
-  if (gGroundProg.program)
+// ring table relative to the outer radius, set when the queue binds the target program
+static void setTargetRings(ShaderProgram &prog)
+{
+  const float R = TARGET_RINGS[0].radius;
+  GLfloat radii[TARGET_RING_COUNT], colors[TARGET_RING_COUNT * 3];
+  for (int i = 0; i < TARGET_RING_COUNT; i++)
   {
-    glUseProgram(gGroundProg.program);
+    radii[i] = TARGET_RINGS[i].radius / R;
+    for (int c = 0; c < 3; c++)
+      colors[i * 3 + c] = TARGET_RINGS[i].color[c];
+  }
+  prog.Set("uRingRadius", radii, TARGET_RING_COUNT);
+  prog.Set("uRingColor", colors, TARGET_RING_COUNT);
+}
 
-    // prepare model/view/proj matrices for shader
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.f, -5.f, 0.f));
-    glm::mat4 view = makeView(camX, camY, camZ);
-    glm::mat4 proj = makeProj(vWidth, vHeight);
-    glm::mat3 normalMat = glm::mat3(glm::transpose(glm::inverse(model)));
+// wave shape and time, set when the queue binds the wave program
+static void setWaveUniforms(ShaderProgram &prog)
+{
+  const float cyclesPerX = (float)gWave.waves / (gWave.x1 - gWave.x0);
+  prog.Set("uWave", glm::vec4(gWave.x0, cyclesPerX, gWave.lift, gWave.amp));
+  prog.Set("uSpeed", gWave.speed);
+  prog.Set("uTime", gWave.time);
+
+  // the strip's samples move with the crests by the part of a cycle travelled so far
+  const float cycles = gWave.speed * gWave.time;
+  const float slide = cyclesPerX > 0.0f ? (cycles - std::floor(cycles)) / cyclesPerX : 0.0f;
+  prog.Set("uSlide", glm::vec3(slide, gWave.x0, gWave.x1));
+}
 
-    glUniformMatrix4fv(gGroundProg.locModel, 1, GL_FALSE, &model[0][0]);
-    glUniformMatrix4fv(gGroundProg.locView, 1, GL_FALSE, &view[0][0]);
-    glUniformMatrix4fv(gGroundProg.locProj, 1, GL_FALSE, &proj[0][0]);
-    glUniformMatrix3fv(gGroundProg.locNormalMat, 1, GL_FALSE, &normalMat[0][0]);
+// start a frame in queue: the scene programs for features, the unit solids and duck materials
+static void beginQueue(RenderQueue &queue, const glm::vec3 &eye, uint32_t features)
+{
+  queue.Begin(eye);
+  gIds.scene = queue.AddProgram(gSceneShader.Get(features));
+  gIds.target = queue.AddProgram(gSceneShader.Get(features | SCENE_TARGET), setTargetRings);
+  gIds.wave = queue.AddProgram(gWaveShader.Get(features), setWaveUniforms);
+
+  gIds.sphere = queue.AddMesh(gSphereMesh.Layout());
+  gIds.eye = queue.AddMesh(gEyeMesh.Layout());
+  gIds.cone = queue.AddMesh(gConeMesh.Layout());
+  gIds.box = queue.AddMesh(gBoxMesh.Layout());
+  gIds.disc = queue.AddMesh(gDiscMesh.Layout());
+
+  gIds.yellow = queue.Material(matte(glm::vec3(1.0f, 1.0f, 0.0f)));
+  gIds.black = queue.Material(matte(glm::vec3(0.0f)));
+  gIds.orange = queue.Material(matte(glm::vec3(1.0f, 0.25f, 0.0f)));
+  gIds.white = queue.Material(matte(glm::vec3(1.0f))); // the rings tint it
+}
 
-    // set simple lighting uniforms for ground shader
-    glUniform3f(gGroundProg.locLightPos, -4.0f, 8.0f, 8.0f);
-    glUniform3f(gGroundProg.locViewPos, camX, camY, camZ);
+// print what the last queue drew, once a second (--stats)
+static void printQueueStats()
+{
+  static auto last = std::chrono::steady_clock::now();
+  const auto now = std::chrono::steady_clock::now();
+  if (now - last < std::chrono::seconds(1))
+    return;
+  last = now;
+  const RenderQueue::Stats &st = gQueue.LastStats();
+  fprintf(stdout, "render queue: %d draws, %d program / %d material / %d mesh changes\n",
+          st.draws, st.programs, st.materials, st.meshes);
+  fprintf(stdout, "culled: booth %d/%d, ground %d/%d, ducks %d/%d (+%d occluded)\n", gCullBooth.culled,
+          gCullBooth.tested, gCullGround.culled, gCullGround.tested, gCullDucks.culled, gCullDucks.tested,
+          gOccludedDucks);
+}
 
-    glUniform3f(gGroundProg.locMatAmbient, 0.12f, 0.28f, 0.12f);
-    glUniform3f(gGroundProg.locMatDiffuse, 0.30f, 0.70f, 0.30f);
-    glUniform3f(gGroundProg.locMatSpecular, 0.12f, 0.12f, 0.12f);
-    glUniform1f(gGroundProg.locMatShininess, 16.0f);
+// count a frustum test, passing its result through
+static bool inView(CullCounts &counts, bool visible)
+{
+  counts.tested++;
+  if (!visible)
+    counts.culled++;
+  return visible;
+}
 
-    groundMesh->DrawMeshVBO(meshSize);
-    glUseProgram(0);
+// queue duck i's occlusion proxy, the box around its bounding sphere, tested against the
+// finished depth buffer; its query answers Visible(i) next frame
+// returns whether the duck is hidden now (the last answer, never when the eye is too close)
+static bool testOcclusion(RenderQueue::List &list, size_t i, const glm::vec3 &center, const glm::vec3 &eye)
+{
+  // with the eye inside the box (or within the near plane of it) its faces get clipped
+  // and could count as hidden, so such a duck is just drawn
+  const float reach = DUCK_BOUND_RADIUS + 1.0f; // near plane
+  const glm::vec3 d = glm::abs(eye - center);
+  if (d.x < reach && d.y < reach && d.z < reach)
+  {
+    gOcclusion.Reset(i);
+    return false;
   }
-  else
+
+  const bool hidden = !gOcclusion.Visible(i);
+  const GLuint query = gOcclusion.Issue(i);
+  if (query)
+    list.Submit(PASS_OCCLUSION, gIds.scene, gIds.white, gIds.box,
+                 glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(2.0f * DUCK_BOUND_RADIUS)), query);
+  return hidden;
+}
+
+// cull and record ducks [begin, end) into chunk (runs on the job pool: only reads the
+// duck state and queue tables, and touches no gl state but the ducks' occlusion slots)
+static void recordDucks(DuckChunk &chunk, size_t begin, size_t end, const glm::vec3 &eye)
+{
+  chunk.list.Begin(gQueue);
+  chunk.quads.clear();
+  chunk.cull = CullCounts();
+  chunk.occluded = 0;
+
+  // draw each duck as geometry up close and as an impostor billboard far away,
+  // crossfading between the two across the fade band
+  for (size_t i = begin; i < end; i++)
   {
-    // fallback immediate-mode draw if no shader
-    glPushMatrix();
-    glTranslatef(0.0, -5.0, 0.0);
-    glColor3f(0.3f, 0.7f, 0.3f);
-    groundMesh->DrawMesh(meshSize);
-    glPopMatrix();
+    // the bounding sphere covers the geometry and the billboard (models are rigid)
+    const glm::mat4 model = duckModelMatrix(i);
+    const glm::vec3 center = glm::vec3(model * glm::vec4(DUCK_BOUND_CENTER, 1.0f));
+    if (!inView(chunk.cull, SphereInFrustum(gFrustum, center, DUCK_BOUND_RADIUS)))
+    {
+      if (occlusionCulling)
+        gOcclusion.Reset(i);
+      continue;
+    }
+
+    float fade = 0.0f;
+    if (gDuckImpostor.texture)
+      fade = glm::clamp((glm::distance(center, eye) - IMPOSTOR_FADE_START) / (IMPOSTOR_FADE_END - IMPOSTOR_FADE_START), 0.0f, 1.0f);
+
+    // billboards are cheap, only ducks drawn as geometry pay for a query
+    if (occlusionCulling && fade < 1.0f)
+    {
+      if (testOcclusion(chunk.list, i, center, eye))
+      {
+        chunk.occluded++;
+        continue;
+      }
+    }
+
+    if (fade < 1.0f)
+      drawDuck(chunk.list, model); // draw duck parts
+    if (fade > 0.0f)
+      chunk.quads.push_back(MakeImpostorQuad(gDuckImpostor, model, eye, fade));
   }
+}
 
-  glutSwapBuffers();
+// submit one opaque part of the duck
+static void drawPart(RenderQueue::List &list, uint32_t mesh, const glm::mat4 &model, uint32_t material)
+{
+  list.Submit(PASS_OPAQUE, gIds.scene, material, mesh, model);
 }
 
 // draw whole duck by composing parts
-void drawDuck()
+void drawDuck(RenderQueue::List &list, const glm::mat4 &model)
 {
-  drawDuckBody();
-  drawDuckNeck();
-  drawDuckHead();
-  drawDuckEyes();
-  drawDuckBeak();
-  drawDuckTail();
-  drawDuckTarget();
+  drawDuckBody(list, model);
+  drawDuckNeck(list, model);
+  drawDuckHead(list, model);
+  drawDuckEyes(list, model);
+  drawDuckBeak(list, model);
+  drawDuckTail(list, model);
+  drawDuckTarget(list, model);
 }
 
 // simple body sphere
-void drawDuckBody()
+void drawDuckBody(RenderQueue::List &list, const glm::mat4 &model)
 {
-  glPushMatrix();
-  glColor3f(1.0, 1.0, 0.0);
-  glScalef(1.15f, 0.95f, 1.05f);
-  glutSolidSphere(1.2f, 30, 30);
-  glPopMatrix();
+  drawPart(list, gIds.sphere, model * gDuckParts[DUCK_BODY], gIds.yellow);
 }
 
 // neck cone connecting body to head
-void drawDuckNeck()
+void drawDuckNeck(RenderQueue::List &list, const glm::mat4 &model)
 {
-  glPushMatrix();
-  glTranslatef(0.36f, 0.36f, 0.0f);
-  glRotatef(90.0f, 0, 1, 0);
-  glRotatef(-90.0f, 1, 0, 0);
-  glColor3f(1.0, 1.0, 0.0);
-  glutSolidCone(0.91f, 1.3f, 20, 12);
-  glPopMatrix();
+  drawPart(list, gIds.cone, model * gDuckParts[DUCK_NECK], gIds.yellow);
 }
 
 // head sphere on top of neck
-void drawDuckHead()
+void drawDuckHead(RenderQueue::List &list, const glm::mat4 &model)
 {
-  glPushMatrix();
-  glTranslatef(0.48f, 1.68f, 0.0f);
-  glColor3f(1.0, 1.0, 0.0);
-  glutSolidSphere(0.65f, 28, 28);
-  glPopMatrix();
+  drawPart(list, gIds.sphere, model * gDuckParts[DUCK_HEAD], gIds.yellow);
 }
 
 // two black eye spheres
-void drawDuckEyes()
+void drawDuckEyes(RenderQueue::List &list, const glm::mat4 &model)
 {
-  glPushMatrix();
-  glTranslatef(0.72f, 1.92f, 0.5f);
-  glColor3f(0.0, 0.0, 0.0);
-  glutSolidSphere(0.117f, 16, 16);
-  glPopMatrix();
-
-  glPushMatrix();
-  glTranslatef(0.72f, 1.92f, -0.5f);
-  glColor3f(0.0, 0.0, 0.0);
-  glutSolidSphere(0.117f, 16, 16);
-  glPopMatrix();
+  drawPart(list, gIds.eye, model * gDuckParts[DUCK_EYE_LEFT], gIds.black);
+  drawPart(list, gIds.eye, model * gDuckParts[DUCK_EYE_RIGHT], gIds.black);
 }
 
 // orange beak cone
-void drawDuckBeak()
+void drawDuckBeak(RenderQueue::List &list, const glm::mat4 &model)
 {
-  glPushMatrix();
-  glTranslatef(1.08f, 1.68f, 0.0f);
-  glRotatef(90, 0, 1, 0);
-  glColor3f(1.0, 0.25, 0.0);
-  glutSolidCone(0.18f, 0.42f, 20, 12);
-  glPopMatrix();
+  drawPart(list, gIds.cone, model * gDuckParts[DUCK_BEAK], gIds.orange);
 }
 
 // tail cone at back of body
-void drawDuckTail()
+void drawDuckTail(RenderQueue::List &list, const glm::mat4 &model)
 {
-  glPushMatrix();
-  glColor3f(1.0, 1.0, 0.0);
-  glTranslatef(-0.96f, 0.6f, 0.0f);
-  glRotatef(-90, 0, 1, 0);
-  glRotatef(-45, 1, 0, 0);
-  glutSolidCone(0.65f, 1.17f, 20, 12);
-  glPopMatrix();
+  drawPart(list, gIds.cone, model * gDuckParts[DUCK_TAIL], gIds.yellow);
 }
 
-// small layered spheres used as target on duck
-void drawDuckTarget()
+// target rings on the duck's side: one disc, ring colors computed per fragment by the
+// TARGET variant; blended for the antialiased ring edges, so it draws after the opaque pass
+void drawDuckTarget(RenderQueue::List &list, const glm::mat4 &model)
 {
-  glPushMatrix();
-  glTranslatef(0.0f, -0.18f, 1.14f);
-  glScalef(0.22f, 0.22f, 0.06f);
-  glColor3f(1.0, 0.0, 0.0);
-  glutSolidSphere(4.0, 30, 30);
-  glPopMatrix();
+  list.Submit(PASS_BLENDED, gIds.target, gIds.white, gIds.disc, model * gDuckParts[DUCK_TARGET]);
+}
 
-  glPushMatrix();
-  glTranslatef(0.0f, -0.18f, 1.26f);
-  glScalef(0.22f, 0.22f, 0.06f);
-  glColor3f(1.0, 1.0, 1.0);
-  glutSolidSphere(3.0, 30, 30);
-  glPopMatrix();
+// compose every duck part's placement in duck space (body and head spheres, neck, beak
+// and tail cones, eyes, target disc)
+static void buildDuckParts()
+{
+  MatrixStack ms;
+
+  ms.Push();
+  ms.Scale(glm::vec3(1.15f, 0.95f, 1.05f));
+  ms.Scale(glm::vec3(1.2f));
+  gDuckParts[DUCK_BODY] = ms.Top();
+  ms.Pop();
+
+  ms.Push();
+  ms.Translate(glm::vec3(0.36f, 0.36f, 0.0f));
+  ms.Rotate(90.0f, glm::vec3(0, 1, 0));
+  ms.Rotate(-90.0f, glm::vec3(1, 0, 0));
+  ms.Scale(glm::vec3(0.91f, 0.91f, 1.3f));
+  gDuckParts[DUCK_NECK] = ms.Top();
+  ms.Pop();
+
+  ms.Push();
+  ms.Translate(glm::vec3(0.48f, 1.68f, 0.0f));
+  ms.Scale(glm::vec3(0.65f));
+  gDuckParts[DUCK_HEAD] = ms.Top();
+  ms.Pop();
+
+  const float eyeZ[2] = {0.5f, -0.5f};
+  for (int e = 0; e < 2; e++)
+  {
+    ms.Push();
+    ms.Translate(glm::vec3(0.72f, 1.92f, eyeZ[e]));
+    ms.Scale(glm::vec3(0.117f));
+    gDuckParts[DUCK_EYE_LEFT + e] = ms.Top();
+    ms.Pop();
+  }
 
-  glPushMatrix();
-  glTranslatef(0.0f, -0.18f, 1.38f);
-  glScalef(0.22f, 0.22f, 0.06f);
-  glColor3f(1.0, 0.0, 0.0);
-  glutSolidSphere(2.0, 30, 30);
-  glPopMatrix();
+  ms.Push();
+  ms.Translate(glm::vec3(1.08f, 1.68f, 0.0f));
+  ms.Rotate(90.0f, glm::vec3(0, 1, 0));
+  ms.Scale(glm::vec3(0.18f, 0.18f, 0.42f));
+  gDuckParts[DUCK_BEAK] = ms.Top();
+  ms.Pop();
+
+  ms.Push();
+  ms.Translate(glm::vec3(-0.96f, 0.6f, 0.0f));
+  ms.Rotate(-90.0f, glm::vec3(0, 1, 0));
+  ms.Rotate(-45.0f, glm::vec3(1, 0, 0));
+  ms.Scale(glm::vec3(0.65f, 0.65f, 1.17f));
+  gDuckParts[DUCK_TAIL] = ms.Top();
+  ms.Pop();
+
+  const float R = TARGET_RINGS[0].radius;
+  ms.Push();
+  ms.Translate(glm::vec3(0.0f, TARGET_CENTER_Y, TARGET_Z));
+  ms.Scale(glm::vec3(R, R, 1.0f));
+  gDuckParts[DUCK_TARGET] = ms.Top();
+  ms.Pop();
 }
 
-// compute wave y at given x using sine function
-float waveYAt(float x)
+// render one impostor cell: the duck at the origin seen by the cell's camera
+static void bakeDuck(const glm::mat4 &view, const glm::mat4 &proj)
 {
-  const float t = (x - gWave.x0) / (gWave.x1 - gWave.x0);
-  return gWave.lift + gWave.amp * glm::sin(2.0f * glm::pi<float>() * gWave.waves * t);
+  FrameBlock frame;
+  frame.view = view;
+  frame.proj = proj;
+  frame.lightPos = LIGHT_POS; // as if the duck stood unrotated at the origin
+  frame.viewPos = glm::inverse(view)[3];
+  frame.fog = glm::vec4(0.0f); // billboards are fogged when drawn
+  gFrameUniforms.Update(frame, gStream);
+
+  static RenderQueue::List list;
+  beginQueue(gQueue, glm::vec3(frame.viewPos), 0);
+  list.Begin(gQueue);
+  drawDuck(list, glm::mat4(1.0f));
+  gQueue.Append(list);
+  gQueue.Execute(gFrameUniforms);
+
+  // every cell is a frame of the stream buffer, fenced like any other
+  gStream.EndFrame();
 }
 
-// draw a 3d wave strip with thickness
-void drawWaterWave3D()
+// draw the water solid just above the base top
+// the sine wave lives in a vbo that is only rebuilt when the wave shape changes,
+// wave.vert moves the surface so animating sends one uniform (uTime) per frame
+void drawWaterWave3D(RenderQueue &queue)
 {
-  const float halfT = gWave.thickZ * 0.5f;
-  const float step = 0.08f;
-
-  glColor3f(0.0f, 0.8f, 1.0f);
-  glBegin(GL_TRIANGLE_STRIP);
-  // top face of wave
-  for (float x = gWave.x0; x <= gWave.x1 + 1e-4f; x += step)
-  {
-    float y = waveYAt(x);
-    glVertex3f(x, y, halfT);
-    glVertex3f(x, y, -halfT);
-  }
-  glEnd();
-
-  // front vertical strip connecting top to base (positive z)
-  glBegin(GL_QUAD_STRIP);
-  for (float x = gWave.x0; x <= gWave.x1 + 1e-4f; x += step)
-  {
-    float y = waveYAt(x);
-    glVertex3f(x, y, halfT);
-    glVertex3f(x, gWave.baseY, halfT);
-  }
-  glEnd();
-
-  // back vertical strip connecting top to base (negative z)
-  glBegin(GL_QUAD_STRIP);
-  for (float x = gWave.x0; x <= gWave.x1 + 1e-4f; x += step)
-  {
-    float y = waveYAt(x);
-    glVertex3f(x, y, -halfT);
-    glVertex3f(x, gWave.baseY, -halfT);
-  }
-  glEnd();
-
-  // bottom rectangle filling the base
-  glBegin(GL_QUADS);
-  glVertex3f(gWave.x0, gWave.baseY, halfT);
-  glVertex3f(gWave.x1, gWave.baseY, halfT);
-  glVertex3f(gWave.x1, gWave.baseY, -halfT);
-  glVertex3f(gWave.x0, gWave.baseY, -halfT);
-  glEnd();
-
-  // left end cap
-  float yL = waveYAt(gWave.x0), yR = waveYAt(gWave.x1);
-  glBegin(GL_QUADS);
-  glVertex3f(gWave.x0, gWave.baseY, halfT);
-  glVertex3f(gWave.x0, yL, halfT);
-  glVertex3f(gWave.x0, yL, -halfT);
-  glVertex3f(gWave.x0, gWave.baseY, -halfT);
-  glEnd();
-
-  // right end cap
-  glBegin(GL_QUADS);
-  glVertex3f(gWave.x1, gWave.baseY, -halfT);
-  glVertex3f(gWave.x1, yR, -halfT);
-  glVertex3f(gWave.x1, yR, halfT);
-  glVertex3f(gWave.x1, gWave.baseY, halfT);
-  glEnd();
-}
-
-// draw a box centered at origin with given width/height/depth
-void drawBox(float w, float h, float d)
-{
-  float hw = w * 0.5f, hh = h * 0.5f, hd = d * 0.5f;
-
-  glBegin(GL_QUADS);
-  // front face
-  glNormal3f(0, 0, 1);
-  glVertex3f(-hw, -hh, hd);
-  glVertex3f(hw, -hh, hd);
-  glVertex3f(hw, hh, hd);
-  glVertex3f(-hw, hh, hd);
-
-  // back face
-  glNormal3f(0, 0, -1);
-  glVertex3f(-hw, -hh, -hd);
-  glVertex3f(-hw, hh, -hd);
-  glVertex3f(hw, hh, -hd);
-  glVertex3f(hw, -hh, -hd);
-
-  // left face
-  glNormal3f(-1, 0, 0);
-  glVertex3f(-hw, -hh, -hd);
-  glVertex3f(-hw, -hh, hd);
-  glVertex3f(-hw, hh, hd);
-  glVertex3f(-hw, hh, -hd);
-
-  // right face
-  glNormal3f(1, 0, 0);
-  glVertex3f(hw, -hh, -hd);
-  glVertex3f(hw, hh, -hd);
-  glVertex3f(hw, hh, hd);
-  glVertex3f(hw, -hh, hd);
-
-  // top face
-  glNormal3f(0, 1, 0);
-  glVertex3f(-hw, hh, -hd);
-  glVertex3f(-hw, hh, hd);
-  glVertex3f(hw, hh, hd);
-  glVertex3f(hw, hh, -hd);
-
-  // bottom face
-  glNormal3f(0, -1, 0);
-  glVertex3f(-hw, -hh, -hd);
-  glVertex3f(hw, -hh, -hd);
-  glVertex3f(hw, -hh, hd);
-  glVertex3f(-hw, -hh, hd);
-  glEnd();
-}
-
-// draw booth: base, pillars, beam and wave surface
-void drawBooth()
-{
-  const float colPillars[3] = {0.447f, 0.443f, 0.506f};
-  const float colBeam[3] = {0.537f, 0.467f, 0.467f};
-
-  if (showBase)
-  {
-    // base box under the wave
-    glColor3fv(colPillars);
-    glPushMatrix();
-    glTranslatef(0.0f, gBooth.baseCenterY, 0.0f);
-    drawBox(gBooth.baseW, gBooth.baseH, gBooth.baseDepth);
-    glPopMatrix();
-  }
-
-  // left pillar
-  glColor3fv(colPillars);
-  glPushMatrix();
-  glTranslatef(-gBooth.pillarX, gBooth.pillarCenterY, 0.0f);
-  drawBox(gBooth.pillarW, gBooth.pillarH, gBooth.pillarW * 1.5f);
-  glPopMatrix();
-
-  // right pillar
-  glPushMatrix();
-  glTranslatef(gBooth.pillarX, gBooth.pillarCenterY, 0.0f);
-  drawBox(gBooth.pillarW, gBooth.pillarH, gBooth.pillarW * 1.5f);
-  glPopMatrix();
+  const glm::mat4 &model = gWaterModel;
+  const uint32_t water = queue.Material(matte(glm::vec3(0.0f, 0.8f, 1.0f)));
+
+  // ocean crests are not bounded by the sine amplitude, give them as much again
+  glm::vec3 lo, hi;
+  waterBounds(lo, hi);
+  if (gOcean)
+    hi.y += gWave.amp;
+  if (!inView(gCullBooth, BoxInFrustum(gFrustum, lo, hi)))
+    return;
+
+  // spectral ocean replaces the sine wave when enabled
+  if (gOcean)
+  {
+    gOceanMesh.Stream(gStream);
+    const RenderMesh mesh = gOceanMesh.Layout();
+    if (mesh.indexCount)
+      queue.Submit(PASS_OPAQUE, gIds.scene, water, queue.AddMesh(mesh), model);
+    return;
+  }
+
+  gWaveMesh.Update(gWave, gWaveTolerance);
+  queue.Submit(PASS_OPAQUE, gIds.wave, water, queue.AddMesh(gWaveMesh.Layout()), model);
+}
+
+// add a box centered at given position with given width/height/depth to the booth parts
+static void addBoothBox(const glm::vec3 &center, float w, float h, float d, const glm::vec3 &color, bool base)
+{
+  MatrixStack ms;
+  ms.Translate(center);
+  ms.Scale(glm::vec3(w, h, d));
+  const glm::vec3 half(w * 0.5f, h * 0.5f, d * 0.5f);
+  gBoothParts.push_back({ms.Top(), center - half, center + half, color, base});
+}
+
+// place the booth boxes and the water from the scene parameters (they never move)
+static void buildBoothParts()
+{
+  const glm::vec3 colPillars(0.447f, 0.443f, 0.506f);
+  const glm::vec3 colBeam(0.537f, 0.467f, 0.467f);
+  gBoothParts.clear();
+
+  // base box under the wave
+  addBoothBox(glm::vec3(0.0f, gBooth.baseCenterY, 0.0f), gBooth.baseW, gBooth.baseH, gBooth.baseDepth, colPillars, true);
+
+  // left and right pillars
+  addBoothBox(glm::vec3(-gBooth.pillarX, gBooth.pillarCenterY, 0.0f), gBooth.pillarW, gBooth.pillarH,
+              gBooth.pillarW * 1.5f, colPillars, false);
+  addBoothBox(glm::vec3(gBooth.pillarX, gBooth.pillarCenterY, 0.0f), gBooth.pillarW, gBooth.pillarH,
+              gBooth.pillarW * 1.5f, colPillars, false);
 
   // top beam across pillars
-  glColor3fv(colBeam);
-  glPushMatrix();
-  glTranslatef(0.0f, gBooth.beamCenterY, 0.0f);
-  drawBox(gBooth.beamW, gBooth.beamH, gBooth.duckBodyR * 2.6f);
-  glPopMatrix();
+  addBoothBox(glm::vec3(0.0f, gBooth.beamCenterY, 0.0f), gBooth.beamW, gBooth.beamH, gBooth.duckBodyR * 2.6f, colBeam,
+              false);
 
-  // draw water surface just above the base top
-  glPushMatrix();
-  glTranslatef(0.0f, gBooth.baseTopY, 0.0f);
-  drawWaterWave3D();
-  glPopMatrix();
+  gWaterModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, gBooth.baseTopY, 0.0f));
+}
+
+// draw booth: base, pillars and beam (the water is drawn by drawWaterWave3D)
+void drawBooth(RenderQueue &queue)
+{
+  for (const BoothPart &part : gBoothParts)
+  {
+    if (part.base && !showBase)
+      continue;
+    if (!inView(gCullBooth, BoxInFrustum(gFrustum, part.lo, part.hi)))
+      continue;
+    queue.Submit(PASS_OPAQUE, gIds.scene, queue.Material(matte(part.color)), gIds.box, part.model);
+  }
 }
 
 // reshape callback updates viewport and projection
@@ -628,8 +1138,10 @@ void reshape(int w, int h)
   glViewport(0, 0, w, h);
   glMatrixMode(GL_PROJECTION);
   glLoadIdentity();
-  gluPerspective(60.0, (GLfloat)w / (GLfloat)h, 1.0, 100.0);
+  gluPerspective(CAMERA_FOV_DEG, (GLfloat)w / (GLfloat)h, 1.0, 100.0);
+  viewportHeight = h > 0 ? h : 1;
   glMatrixMode(GL_MODELVIEW);
+  markDirty();
 }
 
 // keyboard handler for simple controls
@@ -638,114 +1150,108 @@ void keyboard(unsigned char key, int x, int y)
   if (key == 27) // esc to quit
     exit(0);
 
+  // each key that changes something marks the scene dirty; any other key leaves an idle
+  // scene idle
+
   // start flip animation when 'f' pressed and duck is moving forward
-  if ((key == 'f' || key == 'F') && duckState == FORWARD && !isFlipping && !isFlipped)
+  // (while paused it starts once the animation resumes)
+  if (key == 'f' || key == 'F')
+  {
+    RequestDuckFlip(gDucks, 0, gDucks.size());
+    markDirty();
+  }
+
+  // ground shader variants: 'b' blinn-phong, 'g' fog (all prebuilt, switching is free)
+  if (key == 'b' || key == 'B')
+  {
+    sceneFeatures ^= SCENE_BLINN;
+    markDirty();
+  }
+  if (key == 'g' || key == 'G')
   {
-    isFlipping = true;
+    sceneFeatures ^= SCENE_FOG;
+    markDirty();
   }
 
   if (key == 32) // space toggles base visibility
   {
     showBase = !showBase;
-    glutPostRedisplay();
+    markDirty();
+  }
+
+  // 'p' pauses the water and ducks; a paused scene stops the timer until something changes
+  // (the paused time is not simulated afterwards)
+  if (key == 'p' || key == 'P')
+  {
+    animationPaused = !animationPaused;
+    gLastTick = std::chrono::steady_clock::now();
+    gTickTime = 0.0;
+    markDirty();
   }
 }
 
-// animation tick called by glut timer
-void animationHandler(int)
+// something on screen changed: draw it now and keep ticking until the frame settles
+static void markDirty()
 {
-  switch (duckState)
+  gSettleFrames = SETTLE_FRAMES;
+  glutPostRedisplay();
+  if (!gTimerRunning)
   {
-  case FORWARD:
-    // move right across wave
-    duckPos.x += moveSpeed;
-    duckPos.y = waveYAt(duckPos.x) - 0.10f;
-
-    if (duckPos.x >= gWave.x1)
-    {
-      // clamp to right edge and prepare right turn
-      duckPos.x = gWave.x1;
-      duckPos.y = waveYAt(gWave.x1) - 0.10f;
-
-      turnRadius = gWave.amp * 2.4f;
-      turnPivotX = duckPos.x;
-      turnPivotY = duckPos.y - turnRadius;
-
-      duckSpinDeg = 0.0f;
-      duckState = TURN_AT_RIGHT;
-    }
-    break;
-
-  case TURN_AT_RIGHT:
-    // spin around pivot until 180deg reached then set to backward motion
-    duckSpinDeg += spinSpeed;
-    if (duckSpinDeg >= 180.0f)
-    {
-      duckSpinDeg = 180.0f;
-
-      duckPos.x = turnPivotX;
-      duckPos.y = turnPivotY - turnRadius;
-      duckState = BACKWARD;
-    }
-    break;
-
-  case BACKWARD:
-    // move left across wave
-    duckPos.x -= moveSpeed;
-
-    if (duckPos.x <= gWave.x0)
-    {
-      // clamp left edge and prepare left turn
-      duckPos.x = gWave.x0;
-
-      turnRadius = gWave.amp * 2.4f;
-      turnPivotX = duckPos.x;
-      turnPivotY = duckPos.y + turnRadius;
-
-      duckSpinDeg = 0.0f;
-      duckState = TURN_AT_LEFT;
-    }
-    break;
-
-  case TURN_AT_LEFT:
-    // spin until facing forward again
-    duckSpinDeg += spinSpeed;
-    if (duckSpinDeg >= 180.0f)
-    {
-      duckSpinDeg = 180.0f;
-
-      duckPos.x = turnPivotX;
-      duckPos.y = turnPivotY + turnRadius;
-
-      duckSpinDeg = 0.0f;
-      duckState = FORWARD;
-    }
-    break;
+    // the timer was stopped while idle: time from here on, not from the last tick
+    gLastTick = std::chrono::steady_clock::now();
+    gTimerRunning = true;
+    glutTimerFunc(0, animationHandler, 0);
   }
+}
+
+// animation tick called by glut timer: runs the simulation ticks due since the last call
+// (fixed TICK_SECONDS steps, so the game keeps real time and stays deterministic at any
+// frame rate) and asks for a frame
+void animationHandler(int)
+{
+  gTimerRunning = false;
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  const double elapsed = std::chrono::duration<double>(now - gLastTick).count();
+  gLastTick = now;
 
-  // flip animation logic
-  if (isFlipping)
+  if (!animationPaused)
   {
-    // rotate downwards until -90 degrees
-    flipAngle -= flipSpeed;
-    if (flipAngle <= -90.0f)
+    gTickTime = std::min(gTickTime + elapsed, (double)(MAX_TICKS_PER_FRAME * TICK_SECONDS));
+    int ticks = 0;
+    for (; gTickTime >= TICK_SECONDS; gTickTime -= TICK_SECONDS, ticks++)
     {
-      flipAngle = -90.0f;
-      isFlipping = false;
-      isFlipped = true;
+      // advance the water first so ducks ride the surface drawn this frame
+      // (time wraps every period to keep the phase precise); without a wave program
+      // the water is not drawn, so it holds still rather than bob the ducks on nothing
+      if (gWave.speed > 0.0f && gWaveShader.Get(sceneFeatures).program)
+        gWave.time = std::fmod(gWave.time + TICK_SECONDS, 1.0f / gWave.speed);
+      if (gOcean)
+        stepOcean();
+      stepDucks();
     }
+    if (ticks && gOcean)
+      gOceanMesh.Update(*gOcean);
   }
-  else if (isFlipped && duckState == BACKWARD)
+  else if (gSettleFrames > 0)
+    gSettleFrames--;
+  else
   {
-    // auto flip back up while moving backward (left)
-    flipAngle += flipSpeed;
-    if (flipAngle >= 0.0f)
+    // idle: nothing moves, so no frame; only a reloaded shader can change the picture
+    if (gShaderReload && gShaderReload->Poll())
+      gSettleFrames = SETTLE_FRAMES;
+    else
     {
-      flipAngle = 0.0f;
-      isFlipped = false;
+      if (gShaderReload)
+      {
+        gTimerRunning = true;
+        glutTimerFunc(IDLE_POLL_MS, animationHandler, 0);
+      }
+      return;
     }
   }
 
+  // no delay: the swap (vsync) or gPacer (fixed rate) holds the loop to the display
   glutPostRedisplay();
-  glutTimerFunc(16, animationHandler, 0); // schedule next frame (~60fps)
+  gTimerRunning = true;
+  glutTimerFunc(0, animationHandler, 0);
 }
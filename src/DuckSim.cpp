@@ -0,0 +1,166 @@
+#include "DuckSim.h"
+#include "Duck.h"
+#include "Ocean.h"
+#include <algorithm>
+#include <cmath>
+
+// batch update of the duck state machine over struct-of-arrays storage
+// every per-duck decision is written as a select so the inner loops vectorize
+// (needs -fno-trapping-math on gcc/clang, see CMakeLists.txt)
+
+// ducks are processed in chunks so wave heights fit in a small stack buffer
+static const size_t kDuckChunk = 256;
+
+// gallery layout: ducks per lane and spacing between lanes (z)
+static const size_t kDucksPerLane = 8;
+static const float kLaneSpacing = 3.0f;
+
+// resize every array together so they always stay the same length
+void DuckBatch::resize(size_t n)
+{
+  x.resize(n, 0.0f);
+  y.resize(n, 0.0f);
+  z.resize(n, 0.0f);
+  spinDeg.resize(n, 0.0f);
+  pivotX.resize(n, 0.0f);
+  pivotY.resize(n, 0.0f);
+  flipAngle.resize(n, 0.0f);
+  state.resize(n, FORWARD);
+  flipping.resize(n, 0);
+  flipped.resize(n, 0);
+}
+
+// set up count ducks moving forward, spread along the wave and across lanes
+void InitDuckBatch(DuckBatch &ducks, size_t count, const DuckSimParams &params, float startX)
+{
+  ducks.resize(0);
+  ducks.resize(count);
+
+  const float width = params.x1 - params.x0;
+  for (size_t i = 0; i < count; i++)
+  {
+    // stagger ducks within a lane so they don't overlap
+    const float lanePos = (float)(i % kDucksPerLane) * width / (float)kDucksPerLane;
+    ducks.x[i] = params.x0 + std::fmod(startX - params.x0 + lanePos, width);
+    ducks.z[i] = -(float)(i / kDucksPerLane) * kLaneSpacing;
+  }
+
+  waveYAtBatch(ducks.x.data(), ducks.y.data(), count);
+  for (size_t i = 0; i < count; i++)
+    ducks.y[i] -= params.rideOffset;
+}
+
+// flip only starts while moving forward and not already flipping/flipped
+void RequestDuckFlip(DuckBatch &ducks, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; i++)
+  {
+    const bool canFlip = ducks.state[i] == FORWARD && !ducks.flipping[i] && !ducks.flipped[i];
+    ducks.flipping[i] = canFlip ? 1 : ducks.flipping[i];
+  }
+}
+
+// one animation tick for ducks [begin, end)
+void StepDuckBatch(DuckBatch &ducks, const DuckSimParams &params, size_t begin, size_t end)
+{
+  float waveY[kDuckChunk];
+
+  const float moveSpeed = params.moveSpeed;
+  const float spinSpeed = params.spinSpeed;
+  const float flipSpeed = params.flipSpeed;
+  const float radius = params.turnRadius;
+  const float x0 = params.x0, x1 = params.x1;
+
+  for (size_t c = begin; c < end; c += kDuckChunk)
+  {
+    const size_t n = std::min(kDuckChunk, end - c);
+
+    float *__restrict px = ducks.x.data() + c;
+    float *__restrict py = ducks.y.data() + c;
+    const float *__restrict pz = ducks.z.data() + c;
+    float *__restrict spin = ducks.spinDeg.data() + c;
+    float *__restrict pivX = ducks.pivotX.data() + c;
+    float *__restrict pivY = ducks.pivotY.data() + c;
+    float *__restrict flip = ducks.flipAngle.data() + c;
+    int32_t *__restrict st = ducks.state.data() + c;
+    int32_t *__restrict flipping = ducks.flipping.data() + c;
+    int32_t *__restrict flipped = ducks.flipped.data() + c;
+
+    // pass 1: move along the wave, clamped to the edge in the direction of travel
+    for (size_t i = 0; i < n; i++)
+    {
+      const int32_t s = st[i];
+      const float dir = (float)(s == FORWARD) - (float)(s == BACKWARD);
+      const float x = px[i] + dir * moveSpeed;
+      const float hi = x < x1 ? x : x1;
+      const float lo = x > x0 ? x : x0;
+      px[i] = s == FORWARD ? hi : (s == BACKWARD ? lo : x);
+    }
+
+    // pass 2: wave height under every duck in the chunk
+    if (params.ocean)
+      params.ocean->SampleHeights(px, pz, waveY, n);
+    else
+      waveYAtBatch(px, waveY, n);
+    for (size_t i = 0; i < n; i++)
+      waveY[i] -= params.rideOffset;
+
+    // pass 3: edge/turn transitions and target flip
+    // conditions are int32 0/1 masks combined with & and |, never bools with && and ||,
+    // so the compiler keeps them as vector compares instead of branches
+    for (size_t i = 0; i < n; i++)
+    {
+      // load everything up front so the selects below are plain blends
+      const int32_t s = st[i];
+      const float x = px[i];
+      const float wy = waveY[i];
+      const float oldY = py[i];
+      const float oldSpin = spin[i];
+      const float oldPivotX = pivX[i];
+      const float oldPivotY = pivY[i];
+      const float oldFlip = flip[i];
+      const int32_t down = flipping[i];
+      const int32_t wasFlipped = flipped[i];
+
+      const int32_t fwd = (int32_t)(s == FORWARD);
+      const int32_t back = (int32_t)(s == BACKWARD);
+      const int32_t turning = s & 1;
+      const int32_t turnRight = (int32_t)(s == TURN_AT_RIGHT);
+
+      const float y = fwd ? wy : oldY; // only forward ducks ride the wave
+      const float sp = oldSpin + (turning ? spinSpeed : 0.0f);
+
+      // reaching an edge starts a turn around a pivot below (right) or above (left)
+      const int32_t hitRight = fwd & (int32_t)(x >= x1);
+      const int32_t hitLeft = back & (int32_t)(x <= x0);
+      const int32_t hitEdge = hitRight | hitLeft;
+      const float pivotX = hitEdge ? x : oldPivotX;
+      const float pivotY = hitEdge ? y + (hitRight ? -radius : radius) : oldPivotY;
+
+      // finishing a turn lands on the opposite side of the pivot
+      const int32_t turnDone = turning & (int32_t)(sp >= 180.0f);
+      const float landY = pivotY + (turnRight ? -radius : radius);
+      const float doneSpin = turnRight ? 180.0f : 0.0f;
+
+      px[i] = turnDone ? pivotX : x;
+      py[i] = turnDone ? landY : y;
+      pivX[i] = pivotX;
+      pivY[i] = pivotY;
+      spin[i] = hitEdge ? 0.0f : (turnDone ? doneSpin : sp);
+
+      // states are ordered so every transition is a step to the next one
+      const int32_t ns = (s + (hitEdge | turnDone)) & 3;
+      st[i] = ns;
+
+      // flip down while flipping, auto flip back up once moving backward
+      const int32_t up = (down ^ 1) & wasFlipped & (int32_t)(ns == BACKWARD);
+      const float a = oldFlip + (down ? -flipSpeed : (up ? flipSpeed : 0.0f));
+      const int32_t downDone = down & (int32_t)(a <= -90.0f);
+      const int32_t upDone = up & (int32_t)(a >= 0.0f);
+      const float aLo = a > -90.0f ? a : -90.0f;
+      flip[i] = aLo < 0.0f ? aLo : 0.0f;
+      flipping[i] = down & (downDone ^ 1);
+      flipped[i] = (wasFlipped & (upDone ^ 1)) | downDone;
+    }
+  }
+}
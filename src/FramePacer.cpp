@@ -0,0 +1,143 @@
+#include "FramePacer.h"
+#include <GL/glew.h>
+#ifdef _WIN32
+#include <GL/wglew.h>
+#elif !defined(__APPLE__) && !defined(GLEW_EGL)
+#include <GL/glxew.h>
+#endif
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+// fixed mode sleeps until this long before the deadline and spins the rest
+static const std::chrono::microseconds kSpinMargin(2000);
+// a longer gap between presents is the game sitting idle, not a slow frame
+static const double kIdleGapMs = 1000.0;
+
+// set the swap interval of the current context (-1 adaptive), false when the driver can't
+static bool setSwapInterval(int interval)
+{
+#if defined(_WIN32)
+	if (!WGLEW_EXT_swap_control || (interval < 0 && !WGLEW_EXT_swap_control_tear))
+		return false;
+	return wglSwapIntervalEXT(interval) != FALSE;
+#elif !defined(__APPLE__) && !defined(GLEW_EGL)
+	if (GLXEW_EXT_swap_control)
+	{
+		if (interval < 0 && !GLXEW_EXT_swap_control_tear)
+			return false;
+		glXSwapIntervalEXT(glXGetCurrentDisplay(), glXGetCurrentDrawable(), interval);
+		return true;
+	}
+	if (interval >= 0 && GLXEW_MESA_swap_control)
+		return glXSwapIntervalMESA((unsigned)interval) == 0;
+	if (interval > 0 && GLXEW_SGI_swap_control)
+		return glXSwapIntervalSGI(interval) == 0;
+	return false;
+#else
+	(void)interval;
+	return false;
+#endif
+}
+
+static const char *const kModeNames[] = {"vsync", "adaptive", "uncapped", "fixed"};
+
+bool FramePacer::ParseMode(const char *name, PresentMode &mode)
+{
+	for (int i = 0; i <= PRESENT_FIXED; i++)
+	{
+		if (!strcmp(name, kModeNames[i]))
+		{
+			mode = (PresentMode)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *FramePacer::ModeName(PresentMode mode)
+{
+	return kModeNames[mode];
+}
+
+void FramePacer::Init(PresentMode requested, double fixedHz, bool logIntervals)
+{
+	mode = requested;
+	period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fixedHz));
+	scheduled = false;
+	log = logIntervals;
+	timing = false;
+
+	if (mode == PRESENT_ADAPTIVE && !setSwapInterval(-1))
+	{
+		fprintf(stderr, "Adaptive vsync (swap_control_tear) unavailable, using vsync.\n");
+		mode = PRESENT_VSYNC;
+	}
+	if (mode == PRESENT_VSYNC && !setSwapInterval(1))
+	{
+		fprintf(stderr, "Swap interval can't be set, pacing to %.0f Hz on the cpu.\n", fixedHz);
+		mode = PRESENT_FIXED;
+	}
+	// (a fixed mode reached by fallback already failed to set an interval)
+	if (mode == requested && (mode == PRESENT_UNCAPPED || mode == PRESENT_FIXED) && !setSwapInterval(0))
+		fprintf(stderr, "Swap interval can't be set, the driver may still wait for vsync.\n");
+
+	if (mode == PRESENT_FIXED)
+		fprintf(stdout, "Present: fixed %.0f Hz.\n", fixedHz);
+	else
+		fprintf(stdout, "Present: %s.\n", ModeName(mode));
+}
+
+void FramePacer::WaitForPresent()
+{
+	if (mode != PRESENT_FIXED)
+		return;
+
+	const Clock::time_point now = Clock::now();
+	if (!scheduled || now - deadline > period)
+	{
+		// first frame, or more than a frame late: present now and pace from here
+		deadline = now + period;
+		scheduled = true;
+		return;
+	}
+
+	if (deadline - now > kSpinMargin)
+		std::this_thread::sleep_for(deadline - now - kSpinMargin);
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+	deadline += period;
+}
+
+void FramePacer::Presented()
+{
+	if (!log)
+		return;
+
+	const Clock::time_point now = Clock::now();
+	const double ms = std::chrono::duration<double, std::milli>(now - lastPresent).count();
+	lastPresent = now;
+	if (!timing || ms > kIdleGapMs)
+	{
+		// first present, or the first after sitting idle: start a window from here
+		timing = true;
+		windowStart = now;
+		frames = 0;
+		sumMs = 0.0, minMs = 1e9, maxMs = 0.0;
+		return;
+	}
+
+	frames++;
+	sumMs += ms;
+	minMs = ms < minMs ? ms : minMs;
+	maxMs = ms > maxMs ? ms : maxMs;
+
+	if (std::chrono::duration<double>(now - windowStart).count() >= 1.0)
+	{
+		fprintf(stdout, "present (%s): %d frames, interval avg %.2f ms, min %.2f, max %.2f\n", ModeName(mode), frames,
+						sumMs / frames, minMs, maxMs);
+		windowStart = now;
+		frames = 0;
+		sumMs = 0.0, minMs = 1e9, maxMs = 0.0;
+	}
+}
@@ -0,0 +1,47 @@
+#include "FrameUniforms.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include <cstring>
+
+bool FrameUniforms::Supported()
+{
+	return GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object;
+}
+
+void FrameUniforms::Update(const FrameBlock &frame, StreamBuffer &stream)
+{
+	last = frame;
+	if (!Supported())
+		return;
+
+	if (!align)
+	{
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+		if (align < 1)
+			align = 256;
+	}
+
+	GLintptr offset = 0;
+	void *dst = stream.Alloc(sizeof(FrameBlock), (size_t)align, offset);
+	if (!dst)
+	{
+		// frame space used up; the range bound last frame may be rewritten by now, so
+		// draw with no block rather than read it
+		glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, 0);
+		return;
+	}
+	memcpy(dst, &frame, sizeof(FrameBlock));
+	stream.Commit(offset, sizeof(FrameBlock));
+	glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, stream.Buffer(), offset, sizeof(FrameBlock));
+}
+
+void FrameUniforms::Apply(ShaderProgram &prog) const
+{
+	if (Supported())
+		return;
+	prog.Set("uView", last.view);
+	prog.Set("uProj", last.proj);
+	prog.Set("uLightPos", last.lightPos);
+	prog.Set("uViewPos", last.viewPos);
+	prog.Set("uFog", last.fog);
+}
@@ -0,0 +1,74 @@
+#include "Frustum.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+Frustum MakeFrustum(const glm::mat4 &viewProj)
+{
+  // a point is inside when -w <= x, y, z <= w in clip space, so each plane is the
+  // matrix's w row plus or minus one of the x, y, z rows (glm is column-major)
+  const glm::mat4 &m = viewProj;
+  const glm::vec4 rowX(m[0][0], m[1][0], m[2][0], m[3][0]);
+  const glm::vec4 rowY(m[0][1], m[1][1], m[2][1], m[3][1]);
+  const glm::vec4 rowZ(m[0][2], m[1][2], m[2][2], m[3][2]);
+  const glm::vec4 rowW(m[0][3], m[1][3], m[2][3], m[3][3]);
+  const glm::vec4 planes[6] = {rowW + rowX, rowW - rowX, rowW + rowY, rowW - rowY, rowW + rowZ, rowW - rowZ};
+
+  Frustum f;
+  for (int i = 0; i < 8; i++)
+  {
+    const glm::vec4 &p = planes[i % 6];
+    const float len = glm::length(glm::vec3(p));
+    f.nx[i] = p.x / len;
+    f.ny[i] = p.y / len;
+    f.nz[i] = p.z / len;
+    f.d[i] = p.w / len;
+  }
+  return f;
+}
+
+// true when the box center +- extent grown by radius is behind none of the planes:
+// a plane's reach is the projection of the extent on its normal, |n| . extent
+static bool inFrustum(const Frustum &f, const glm::vec3 &c, const glm::vec3 &e, float radius)
+{
+#if FRUSTUM_SSE
+  const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+  const __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+  const __m128 r = _mm_set1_ps(radius);
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  for (int i = 0; i < 8; i += 4)
+  {
+    const __m128 nx = _mm_loadu_ps(f.nx + i), ny = _mm_loadu_ps(f.ny + i), nz = _mm_loadu_ps(f.nz + i);
+    const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+                                   _mm_add_ps(_mm_mul_ps(nz, cz), _mm_loadu_ps(f.d + i)));
+    const __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex),
+                                               _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+                                    _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nz), ez), r));
+    if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, reach), _mm_setzero_ps())))
+      return false;
+  }
+  return true;
+#else
+  for (int i = 0; i < 6; i++)
+  {
+    const float dist = f.nx[i] * c.x + f.ny[i] * c.y + f.nz[i] * c.z + f.d[i];
+    const float reach = std::fabs(f.nx[i]) * e.x + std::fabs(f.ny[i]) * e.y + std::fabs(f.nz[i]) * e.z + radius;
+    if (dist + reach < 0.0f)
+      return false;
+  }
+  return true;
+#endif
+}
+
+bool SphereInFrustum(const Frustum &f, const glm::vec3 &center, float radius)
+{
+  return inFrustum(f, center, glm::vec3(0.0f), radius);
+}
+
+bool BoxInFrustum(const Frustum &f, const glm::vec3 &lo, const glm::vec3 &hi)
+{
+  return inFrustum(f, (lo + hi) * 0.5f, (hi - lo) * 0.5f, 0.0f);
+}
@@ -0,0 +1,197 @@
+#include "Impostor.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// octahedral impostors: cell (i, j) of the atlas holds the object seen from the
+// direction that the octahedral map sends the cell center to
+
+// sign that treats zero as positive (keeps the octahedral fold seamless)
+static float signNotZero(float v)
+{
+  return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+// [-1,1]^2 -> unit direction
+static glm::vec3 octDecode(glm::vec2 p)
+{
+  glm::vec3 d(p.x, p.y, 1.0f - std::fabs(p.x) - std::fabs(p.y));
+  if (d.z < 0.0f)
+  {
+    // lower hemisphere is folded over the diagonals
+    const float x = d.x;
+    d.x = (1.0f - std::fabs(d.y)) * signNotZero(x);
+    d.y = (1.0f - std::fabs(x)) * signNotZero(d.y);
+  }
+  return glm::normalize(d);
+}
+
+// unit direction -> [-1,1]^2
+static glm::vec2 octEncode(glm::vec3 d)
+{
+  d = d * (1.0f / (std::fabs(d.x) + std::fabs(d.y) + std::fabs(d.z)));
+  if (d.z >= 0.0f)
+    return glm::vec2(d.x, d.y);
+  return glm::vec2((1.0f - std::fabs(d.y)) * signNotZero(d.x), (1.0f - std::fabs(d.x)) * signNotZero(d.y));
+}
+
+// view direction baked into cell (i, j)
+static glm::vec3 cellDirection(int grid, int i, int j)
+{
+  glm::vec2 uv(((float)i + 0.5f) / (float)grid, ((float)j + 0.5f) / (float)grid);
+  return octDecode(uv * 2.0f - 1.0f);
+}
+
+// up vector used when baking a cell (world y unless looking straight along it)
+static glm::vec3 bakeUp(const glm::vec3 &dir)
+{
+  glm::vec3 ref = std::fabs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+  return glm::normalize(ref - dir * glm::dot(ref, dir));
+}
+
+// render the object once per cell into an offscreen atlas
+bool BakeImpostorAtlas(ImpostorAtlas &atlas, int grid, int cellSize, glm::vec3 center, float radius,
+                       void (*draw)(const glm::mat4 &view, const glm::mat4 &proj))
+{
+  if (!GLEW_VERSION_3_0 && !GLEW_ARB_framebuffer_object)
+    return false;
+
+  const int size = grid * cellSize;
+  atlas.grid = grid;
+  atlas.cellSize = cellSize;
+  atlas.center = center;
+  atlas.radius = radius;
+
+  // color target: transparent where the object isn't
+  glGenTextures(1, &atlas.texture);
+  glBindTexture(GL_TEXTURE_2D, atlas.texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // depth and framebuffer are only needed while baking
+  GLuint fbo = 0, depth = 0;
+  glGenRenderbuffers(1, &depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas.texture, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+  bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  if (ok)
+  {
+    // save the state we touch
+    GLint viewport[4];
+    GLfloat clearColor[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glViewport(0, 0, size, size);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // orthographic box just holding the bounding sphere, eye at twice the radius
+    const glm::mat4 proj = glm::ortho(-radius, radius, -radius, radius, radius * 0.5f, radius * 3.5f);
+
+    for (int j = 0; j < grid; j++)
+    {
+      for (int i = 0; i < grid; i++)
+      {
+        const glm::vec3 dir = cellDirection(grid, i, j);
+        const glm::mat4 view = glm::lookAt(center + dir * (radius * 2.0f), center, bakeUp(dir));
+        glViewport(i * cellSize, j * cellSize, cellSize, cellSize);
+        draw(view, proj);
+      }
+    }
+
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &depth);
+
+  if (!ok)
+    DestroyImpostorAtlas(atlas);
+  return ok;
+}
+
+// release the atlas texture
+void DestroyImpostorAtlas(ImpostorAtlas &atlas)
+{
+  if (atlas.texture)
+    glDeleteTextures(1, &atlas.texture);
+  atlas.texture = 0;
+  atlas.grid = 0;
+}
+
+// pick the cell closest to the current view and the up vector it was baked with
+ImpostorQuad MakeImpostorQuad(const ImpostorAtlas &atlas, const glm::mat4 &model, const glm::vec3 &eye, float alpha)
+{
+  ImpostorQuad q;
+  q.worldCenter = glm::vec3(model * glm::vec4(atlas.center, 1.0f));
+  q.toEyeWorld = glm::normalize(eye - q.worldCenter);
+
+  // rotation part of the model matrix is orthonormal, so its transpose inverts it
+  const glm::mat3 rot(model);
+  q.toEyeLocal = glm::normalize(glm::transpose(rot) * q.toEyeWorld);
+
+  const glm::vec2 uv = octEncode(q.toEyeLocal) * 0.5f + 0.5f;
+  const int i = glm::clamp((int)(uv.x * (float)atlas.grid), 0, atlas.grid - 1);
+  const int j = glm::clamp((int)(uv.y * (float)atlas.grid), 0, atlas.grid - 1);
+
+  q.bakeUpWorld = rot * bakeUp(cellDirection(atlas.grid, i, j));
+  const float cell = 1.0f / (float)atlas.grid;
+  q.uv = glm::vec4(i * cell, j * cell, (i + 1) * cell, (j + 1) * cell);
+  q.alpha = alpha;
+  return q;
+}
+
+// camera-facing quads, rolled so the baked up vector matches the object's orientation
+void DrawImpostors(const ImpostorAtlas &atlas, const ImpostorQuad *quads, size_t count)
+{
+  if (!atlas.texture || count == 0)
+    return;
+
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT);
+  glDisable(GL_LIGHTING); // lighting is baked into the atlas
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, atlas.texture);
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glEnable(GL_ALPHA_TEST);
+  glAlphaFunc(GL_GREATER, 0.05f);
+
+  const float r = atlas.radius;
+  glBegin(GL_QUADS);
+  for (size_t k = 0; k < count; k++)
+  {
+    const ImpostorQuad &q = quads[k];
+    const glm::vec3 up = glm::normalize(q.bakeUpWorld - q.toEyeWorld * glm::dot(q.bakeUpWorld, q.toEyeWorld)) * r;
+    const glm::vec3 right = glm::normalize(glm::cross(up, q.toEyeWorld)) * r;
+    const glm::vec3 c = q.worldCenter;
+
+    glColor4f(1.0f, 1.0f, 1.0f, q.alpha);
+    glTexCoord2f(q.uv.x, q.uv.y);
+    glVertex3f(c.x - right.x - up.x, c.y - right.y - up.y, c.z - right.z - up.z);
+    glTexCoord2f(q.uv.z, q.uv.y);
+    glVertex3f(c.x + right.x - up.x, c.y + right.y - up.y, c.z + right.z - up.z);
+    glTexCoord2f(q.uv.z, q.uv.w);
+    glVertex3f(c.x + right.x + up.x, c.y + right.y + up.y, c.z + right.z + up.z);
+    glTexCoord2f(q.uv.x, q.uv.w);
+    glVertex3f(c.x - right.x + up.x, c.y - right.y + up.y, c.z - right.z + up.z);
+  }
+  glEnd();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glPopAttrib();
+}
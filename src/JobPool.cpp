@@ -0,0 +1,106 @@
+#include "JobPool.h"
+
+// start threadCount - 1 workers (the caller is the remaining thread)
+JobPool::JobPool(unsigned threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (unsigned i = 1; i < threadCount; i++)
+		workers.emplace_back(&JobPool::WorkerLoop, this);
+}
+
+// tell workers to quit and join them
+JobPool::~JobPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &t : workers)
+		t.join();
+}
+
+// split [0, count) into fixed chunks, run them on every thread and wait for completion
+void JobPool::ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)> &fn)
+{
+	if (count == 0)
+		return;
+	if (chunkSize == 0)
+		chunkSize = 1;
+
+	// no workers or a single chunk: just run it here
+	if (workers.empty() || count <= chunkSize)
+	{
+		for (size_t begin = 0; begin < count; begin += chunkSize)
+			fn(begin, begin + chunkSize < count ? begin + chunkSize : count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &fn;
+		jobCount = count;
+		jobChunk = chunkSize;
+		numChunks = (count + chunkSize - 1) / chunkSize;
+		nextChunk.store(0);
+		chunksDone = 0;
+		generation++;
+	}
+	wake.notify_all();
+
+	RunChunks();
+
+	// barrier: every chunk finished and no worker still touching the job
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return chunksDone == numChunks && activeWorkers == 0; });
+	job = nullptr;
+}
+
+// grab chunk indices until the job runs out, then report how many were run
+void JobPool::RunChunks()
+{
+	size_t ran = 0;
+	for (;;)
+	{
+		const size_t chunk = nextChunk.fetch_add(1);
+		if (chunk >= numChunks)
+			break;
+		const size_t begin = chunk * jobChunk;
+		const size_t end = begin + jobChunk < jobCount ? begin + jobChunk : jobCount;
+		(*job)(begin, end);
+		ran++;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	chunksDone += ran;
+	if (chunksDone == numChunks)
+		done.notify_all();
+}
+
+// worker: sleep until a new job generation appears, help with it, repeat
+void JobPool::WorkerLoop()
+{
+	unsigned seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || (generation != seen && job); });
+			if (quit)
+				return;
+			seen = generation;
+			activeWorkers++;
+		}
+
+		RunChunks();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		activeWorkers--;
+		if (activeWorkers == 0)
+			done.notify_all();
+	}
+}
@@ -0,0 +1,56 @@
+#include "OcclusionQueries.h"
+
+OcclusionQueries::~OcclusionQueries()
+{
+	if (!queries.empty())
+		glDeleteQueries((GLsizei)queries.size(), queries.data());
+}
+
+bool OcclusionQueries::Supported()
+{
+	return GLEW_VERSION_1_5 || GLEW_ARB_occlusion_query;
+}
+
+void OcclusionQueries::Resize(size_t count)
+{
+	const size_t old = queries.size();
+	if (count < old)
+		glDeleteQueries((GLsizei)(old - count), queries.data() + count);
+	queries.resize(count, 0);
+	if (count > old)
+		glGenQueries((GLsizei)(count - old), queries.data() + old);
+	pending.resize(count, 0);
+	visible.resize(count, 1);
+}
+
+void OcclusionQueries::Poll()
+{
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		if (!pending[i])
+			continue;
+		GLuint ready = 0;
+		glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &ready);
+		if (ready)
+		{
+			GLuint samples = 0;
+			glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &samples);
+			visible[i] = samples > 0;
+			pending[i] = 0;
+		}
+	}
+}
+
+void OcclusionQueries::Reset(size_t i)
+{
+	visible[i] = 1;
+	pending[i] = 0; // a late result would describe an old view, reissuing drops it
+}
+
+GLuint OcclusionQueries::Issue(size_t i)
+{
+	if (pending[i])
+		return 0;
+	pending[i] = 1;
+	return queries[i];
+}
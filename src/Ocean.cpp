@@ -0,0 +1,241 @@
+#include "Ocean.h"
+#include "JobPool.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// rows per job chunk and tile size for the blocked transposes
+// (a 32 x 32 tile of complex floats is 8 KB, both tiles fit in l1)
+static const size_t kRowChunk = 8;
+static const int kTile = 32;
+
+static const float kGravity = 9.81f;
+static const float kTwoPi = 6.28318530718f;
+
+// spectrum repeats after this many seconds (frequencies are quantized to it)
+static const float kLoopSeconds = 64.0f;
+
+// phillips spectrum for wave vector (kx, kz): A exp(-1 / (k L)^2) / k^4 |k.w|^2,
+// with waves moving against the wind damped and tiny ripples suppressed
+static float phillips(float kx, float kz, float windSpeed, float wx, float wz)
+{
+	const float k2 = kx * kx + kz * kz;
+	if (k2 < 1e-12f)
+		return 0.0f;
+
+	const float L = windSpeed * windSpeed / kGravity; // largest wave from the wind
+	const float k = std::sqrt(k2);
+	const float kw = (kx * wx + kz * wz) / k;
+	const float small = L * 0.001f;
+
+	float p = std::exp(-1.0f / (k2 * L * L)) / (k2 * k2) * kw * kw;
+	if (kw < 0.0f)
+		p *= 0.07f;
+	return p * std::exp(-k2 * small * small);
+}
+
+Ocean::Ocean(int size, float patchSize, float windSpeed, float windDirX, float windDirZ, float heightRms,
+						 float baseHeight, unsigned seed)
+		: n(size), patch(patchSize), loopPeriod(kLoopSeconds), base(baseHeight)
+{
+	while ((1 << logN) < n)
+		logN++;
+
+	const float wl = std::sqrt(windDirX * windDirX + windDirZ * windDirZ);
+	const float wx = wl > 0.0f ? windDirX / wl : 1.0f;
+	const float wz = wl > 0.0f ? windDirZ / wl : 0.0f;
+
+	// fft tables: bit reversal and twiddles for the inverse transform
+	bitrev.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		unsigned r = 0;
+		for (int b = 0; b < logN; b++)
+			r |= ((i >> b) & 1) << (logN - 1 - b);
+		bitrev[i] = r;
+	}
+	// per stage tables: stage with half size h holds exp(+2 pi i j / 2h) for j < h at h - 1
+	twiddleRe.resize(n - 1);
+	twiddleIm.resize(n - 1);
+	for (int half = 1; half < n; half <<= 1)
+		for (int j = 0; j < half; j++)
+		{
+			const double a = 3.14159265358979323846 * j / half;
+			twiddleRe[half - 1 + j] = (float)std::cos(a);
+			twiddleIm[half - 1 + j] = (float)std::sin(a);
+		}
+
+	// wave vector of fft index i (natural fft order, negative frequencies in the upper half)
+	auto waveNumber = [&](int i)
+	{ return kTwoPi * (float)(i < n / 2 ? i : i - n) / patchSize; };
+
+	// h0(k) = gaussian * sqrt(P(k) / 2), fixed seed so every run gets the same sea
+	std::mt19937 rng(seed);
+	std::normal_distribution<float> gauss(0.0f, 1.0f);
+	h0.resize((size_t)n * n);
+	omegaStep.resize((size_t)n * n);
+	const float omega0 = kTwoPi / loopPeriod;
+	for (int z = 0; z < n; z++)
+		for (int x = 0; x < n; x++)
+		{
+			const float kx = waveNumber(x), kz = waveNumber(z);
+			const float amp = std::sqrt(phillips(kx, kz, windSpeed, wx, wz) * 0.5f);
+			const float gr = gauss(rng), gi = gauss(rng);
+			h0[(size_t)z * n + x] = Complex(gr * amp, gi * amp);
+
+			const float w = std::sqrt(kGravity * std::sqrt(kx * kx + kz * kz));
+			const unsigned m = (unsigned)std::floor(w / omega0);
+			omegaStep[(size_t)z * n + x] = m;
+			maxStep = m > maxStep ? m : maxStep;
+		}
+	phase.resize(maxStep + 1);
+
+	h0MinusConj.resize((size_t)n * n);
+	for (int z = 0; z < n; z++)
+		for (int x = 0; x < n; x++)
+			h0MinusConj[(size_t)z * n + x] = std::conj(h0[(size_t)((n - z) & (n - 1)) * n + ((n - x) & (n - 1))]);
+
+	// parseval: the unnormalized inverse fft has mean |h|^2 = sum |H(k)|^2
+	// fold the scale into the spectrum and flush coefficients far below the peak to zero,
+	// the spectrum tails would otherwise be denormals that crawl through every fft
+	double energy = 0.0, peak = 0.0;
+	for (size_t i = 0; i < h0.size(); i++)
+	{
+		energy += std::norm(h0[i] + h0MinusConj[i]);
+		peak = std::max(peak, (double)std::abs(h0[i]));
+	}
+	const float scale = energy > 0.0 ? heightRms / (float)std::sqrt(energy) : 0.0f;
+	const float cutoff = (float)(peak * 1e-7) * scale;
+	for (size_t i = 0; i < h0.size(); i++)
+	{
+		h0[i] *= scale;
+		h0MinusConj[i] *= scale;
+		if (std::abs(h0[i]) < cutoff)
+			h0[i] = 0.0f;
+		if (std::abs(h0MinusConj[i]) < cutoff)
+			h0MinusConj[i] = 0.0f;
+	}
+
+	spectrum.resize((size_t)n * n);
+	columns.resize((size_t)n * n);
+	heights.assign((size_t)n * n, 0.0f);
+}
+
+// iterative radix-2 inverse fft of each row (no 1/n, the spectrum scale absorbs it)
+// works on the complex data as float pairs with split twiddle tables laid out per
+// stage, so every inner loop walks memory linearly and the compiler can vectorize it
+void Ocean::FftRows(Complex *data, size_t begin, size_t end) const
+{
+	const float *twRe = twiddleRe.data();
+	const float *twIm = twiddleIm.data();
+
+	for (size_t row = begin; row < end; row++)
+	{
+		Complex *a = data + row * n;
+		for (int i = 0; i < n; i++)
+		{
+			const unsigned j = bitrev[i];
+			if ((unsigned)i < j)
+				std::swap(a[i], a[j]);
+		}
+
+		// std::complex<float> is laid out as float[2]
+		float *f = reinterpret_cast<float *>(a);
+		for (int half = 1; half < n; half <<= 1)
+		{
+			// this stage's twiddles exp(+2 pi i j / (2 half)) start at offset half - 1
+			const float *wr = twRe + half - 1;
+			const float *wi = twIm + half - 1;
+			for (int i = 0; i < n; i += 2 * half)
+			{
+				float *__restrict lo = f + 2 * i;
+				float *__restrict hi = f + 2 * (i + half);
+				for (int j = 0; j < half; j++)
+				{
+					const float br = hi[2 * j], bi = hi[2 * j + 1];
+					const float vr = br * wr[j] - bi * wi[j];
+					const float vi = br * wi[j] + bi * wr[j];
+					const float ur = lo[2 * j], ui = lo[2 * j + 1];
+					lo[2 * j] = ur + vr;
+					lo[2 * j + 1] = ui + vi;
+					hi[2 * j] = ur - vr;
+					hi[2 * j + 1] = ui - vi;
+				}
+			}
+		}
+	}
+}
+
+void Ocean::Update(float time, JobPool &jobs)
+{
+	const size_t rows = (size_t)n;
+
+	// every frequency is m * w0, so e^(i w t) comes from a table of maxStep + 1 entries
+	const float omega0 = kTwoPi / loopPeriod;
+	for (unsigned m = 0; m <= maxStep; m++)
+	{
+		const float a = omega0 * (float)m * time;
+		phase[m] = Complex(std::cos(a), std::sin(a));
+	}
+
+	// 1. evolve rows of the spectrum to time and transform them along x
+	//    H(k, t) = h0(k) e^(i w t) + conj(h0(-k)) e^(-i w t)
+	//    (plain float pairs again: gcc builds std::complex values through the stack here)
+	jobs.ParallelFor(rows, kRowChunk, [&](size_t begin, size_t end)
+									 {
+		const float *a = reinterpret_cast<const float *>(h0.data());
+		const float *b = reinterpret_cast<const float *>(h0MinusConj.data());
+		const float *e = reinterpret_cast<const float *>(phase.data());
+		const unsigned *step = omegaStep.data();
+		float *out = reinterpret_cast<float *>(spectrum.data());
+		for (size_t i = begin * n; i < end * n; i++)
+		{
+			const float c = e[2 * step[i]], s = e[2 * step[i] + 1];
+			const float ar = a[2 * i], ai = a[2 * i + 1], br = b[2 * i], bi = b[2 * i + 1];
+			out[2 * i] = (ar + br) * c - (ai - bi) * s;
+			out[2 * i + 1] = (ai + bi) * c + (ar - br) * s;
+		}
+		FftRows(spectrum.data(), begin, end); });
+
+	// 2. blocked transpose so columns become rows, then transform along z
+	//    each chunk owns whole destination rows, so it can run its fft right away
+	jobs.ParallelFor(rows, kRowChunk, [&](size_t begin, size_t end)
+									 {
+		for (size_t zt = 0; zt < rows; zt += kTile)
+			for (size_t x = begin; x < end; x++)
+				for (size_t z = zt; z < zt + kTile && z < rows; z++)
+					columns[x * n + z] = spectrum[z * n + x];
+		FftRows(columns.data(), begin, end); });
+
+	// 3. transpose back into z-major heights, keeping the real part
+	jobs.ParallelFor(rows, kTile, [&](size_t begin, size_t end)
+									 {
+		for (size_t xt = 0; xt < rows; xt += kTile)
+			for (size_t z = begin; z < end; z++)
+				for (size_t x = xt; x < xt + kTile && x < rows; x++)
+					heights[z * n + x] = columns[x * n + z].real(); });
+}
+
+float Ocean::Height(float x, float z) const
+{
+	const float u = x / patch * (float)n, v = z / patch * (float)n;
+	const float fu = std::floor(u), fv = std::floor(v);
+	const float tu = u - fu, tv = v - fv;
+
+	// wrap with the power of two mask (works for negative indices too)
+	const int mask = n - 1;
+	const int x0 = (int)fu & mask, x1 = (x0 + 1) & mask;
+	const int z0 = (int)fv & mask, z1 = (z0 + 1) & mask;
+
+	const float h00 = heights[(size_t)z0 * n + x0], h10 = heights[(size_t)z0 * n + x1];
+	const float h01 = heights[(size_t)z1 * n + x0], h11 = heights[(size_t)z1 * n + x1];
+	const float a = h00 + (h10 - h00) * tu;
+	const float b = h01 + (h11 - h01) * tu;
+	return base + a + (b - a) * tv;
+}
+
+void Ocean::SampleHeights(const float *xs, const float *zs, float *ys, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		ys[i] = Height(xs[i], zs[i]);
+}
@@ -0,0 +1,156 @@
+#include "OceanMesh.h"
+#include "Ocean.h"
+#include "ShaderUtils.h"
+#include "StreamBuffer.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// vertex layout (indices into vertices):
+//   [0, nx*nz)              top grid, row-major in z
+//   then front/back skirts  2 per x sample (base, surface)
+//   then left/right caps    2 per z sample (base, surface)
+//   then 4 bottom corners
+
+void OceanMesh::Init(float ax0, float ax1, float az0, float az1, float abaseY)
+{
+	x0 = ax0, x1 = ax1, z0 = az0, z1 = az1, baseY = abaseY;
+
+	nx = (int)std::ceil((x1 - x0) / step) + 1;
+	nz = (int)std::ceil((z1 - z0) / step) + 1;
+	if (nx < 2)
+		nx = 2;
+	if (nz < 2)
+		nz = 2;
+
+	// grid samples land exactly on the rectangle edges
+	xs.resize((size_t)nx * nz);
+	zs.resize((size_t)nx * nz);
+	ys.resize((size_t)nx * nz);
+	for (int iz = 0; iz < nz; iz++)
+		for (int ix = 0; ix < nx; ix++)
+		{
+			xs[(size_t)iz * nx + ix] = ix == nx - 1 ? x1 : x0 + (x1 - x0) * (float)ix / (float)(nx - 1);
+			zs[(size_t)iz * nx + ix] = iz == nz - 1 ? z1 : z0 + (z1 - z0) * (float)iz / (float)(nz - 1);
+		}
+
+	vertices.assign((size_t)nx * nz + 4 * nx + 4 * nz + 4, MeshVertex());
+	indices.clear();
+
+	// two triangles for quad a b c d (counter-clockwise seen from outside)
+	auto quad = [&](unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+	{
+		indices.insert(indices.end(), {a, b, c, a, c, d});
+	};
+
+	// top surface
+	for (int iz = 0; iz + 1 < nz; iz++)
+		for (int ix = 0; ix + 1 < nx; ix++)
+		{
+			const unsigned int a = iz * nx + ix;
+			quad(a, a + nx, a + nx + 1, a + 1);
+		}
+
+	// front (z1) and back (z0) skirts
+	const unsigned int front = nx * nz, back = front + 2 * nx;
+	for (int ix = 0; ix + 1 < nx; ix++)
+	{
+		quad(front + 2 * ix, front + 2 * ix + 2, front + 2 * ix + 3, front + 2 * ix + 1);
+		quad(back + 2 * ix, back + 2 * ix + 1, back + 2 * ix + 3, back + 2 * ix + 2);
+	}
+
+	// left (x0) and right (x1) caps
+	const unsigned int left = back + 2 * nx, right = left + 2 * nz;
+	for (int iz = 0; iz + 1 < nz; iz++)
+	{
+		quad(left + 2 * iz, left + 2 * iz + 2, left + 2 * iz + 3, left + 2 * iz + 1);
+		quad(right + 2 * iz, right + 2 * iz + 1, right + 2 * iz + 3, right + 2 * iz + 2);
+	}
+
+	// bottom
+	const unsigned int bottom = right + 2 * nz;
+	quad(bottom, bottom + 1, bottom + 2, bottom + 3);
+	vertices[bottom + 0] = {glm::vec3(x0, baseY, z0), glm::vec3(0, -1, 0)};
+	vertices[bottom + 1] = {glm::vec3(x1, baseY, z0), glm::vec3(0, -1, 0)};
+	vertices[bottom + 2] = {glm::vec3(x1, baseY, z1), glm::vec3(0, -1, 0)};
+	vertices[bottom + 3] = {glm::vec3(x0, baseY, z1), glm::vec3(0, -1, 0)};
+
+	if (!ebo)
+		glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	ready = true;
+}
+
+void OceanMesh::Update(const Ocean &ocean)
+{
+	if (!ready)
+		return;
+
+	ocean.SampleHeights(xs.data(), zs.data(), ys.data(), ys.size());
+
+	// top grid: central differences (one-sided on the border) for the normal
+	const float dx = (x1 - x0) / (float)(nx - 1), dz = (z1 - z0) / (float)(nz - 1);
+	for (int iz = 0; iz < nz; iz++)
+		for (int ix = 0; ix < nx; ix++)
+		{
+			const int xl = ix > 0 ? ix - 1 : ix, xr = ix < nx - 1 ? ix + 1 : ix;
+			const int zl = iz > 0 ? iz - 1 : iz, zr = iz < nz - 1 ? iz + 1 : iz;
+			const float sx = (ys[(size_t)iz * nx + xr] - ys[(size_t)iz * nx + xl]) / ((float)(xr - xl) * dx);
+			const float sz = (ys[(size_t)zr * nx + ix] - ys[(size_t)zl * nx + ix]) / ((float)(zr - zl) * dz);
+
+			const size_t i = (size_t)iz * nx + ix;
+			vertices[i] = {glm::vec3(xs[i], ys[i], zs[i]), glm::normalize(glm::vec3(-sx, 1.0f, -sz))};
+		}
+
+	// skirts and caps follow the border of the grid
+	const size_t front = (size_t)nx * nz, back = front + 2 * nx;
+	for (int ix = 0; ix < nx; ix++)
+	{
+		const size_t f = (size_t)(nz - 1) * nx + ix, b = ix;
+		vertices[front + 2 * ix] = {glm::vec3(xs[f], baseY, z1), glm::vec3(0, 0, 1)};
+		vertices[front + 2 * ix + 1] = {glm::vec3(xs[f], ys[f], z1), glm::vec3(0, 0, 1)};
+		vertices[back + 2 * ix] = {glm::vec3(xs[b], baseY, z0), glm::vec3(0, 0, -1)};
+		vertices[back + 2 * ix + 1] = {glm::vec3(xs[b], ys[b], z0), glm::vec3(0, 0, -1)};
+	}
+	const size_t left = back + 2 * nx, right = left + 2 * nz;
+	for (int iz = 0; iz < nz; iz++)
+	{
+		const size_t l = (size_t)iz * nx, r = (size_t)iz * nx + nx - 1;
+		vertices[left + 2 * iz] = {glm::vec3(x0, baseY, zs[l]), glm::vec3(-1, 0, 0)};
+		vertices[left + 2 * iz + 1] = {glm::vec3(x0, ys[l], zs[l]), glm::vec3(-1, 0, 0)};
+		vertices[right + 2 * iz] = {glm::vec3(x1, baseY, zs[r]), glm::vec3(1, 0, 0)};
+		vertices[right + 2 * iz + 1] = {glm::vec3(x1, ys[r], zs[r]), glm::vec3(1, 0, 0)};
+	}
+}
+
+void OceanMesh::Stream(StreamBuffer &stream)
+{
+	streamVbo = 0;
+	if (!ready)
+		return;
+
+	const size_t bytes = sizeof(MeshVertex) * vertices.size();
+	void *dst = stream.Alloc(bytes, sizeof(float), streamOffset);
+	if (!dst)
+		return; // no room this frame, the water is skipped
+	memcpy(dst, vertices.data(), bytes);
+	stream.Commit(streamOffset, bytes);
+	streamVbo = stream.Buffer();
+}
+
+RenderMesh OceanMesh::Layout() const
+{
+	RenderMesh mesh;
+	if (!ready || !streamVbo)
+		return mesh;
+	const size_t base = (size_t)streamOffset;
+	mesh.streams[0] = {streamVbo, ATTRIB_POS, 3, sizeof(MeshVertex), base + offsetof(MeshVertex, position)};
+	mesh.streams[1] = {streamVbo, ATTRIB_NORMAL, 3, sizeof(MeshVertex), base + offsetof(MeshVertex, normal)};
+	mesh.streamCount = 2;
+	mesh.indexBuffer = ebo;
+	mesh.indexCount = (GLsizei)indices.size();
+	return mesh;
+}
@@ -0,0 +1,171 @@
+#include "ProgramCache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// cache file layout: header followed by the driver's binary blob
+struct CacheHeader
+{
+  uint32_t magic;   // CACHE_MAGIC
+  uint32_t version; // CACHE_VERSION, bump when the key or layout changes
+  uint64_t key;     // repeated so a renamed file can't be mistaken for another entry
+  uint32_t format;  // binaryFormat from glGetProgramBinary
+  uint32_t length;  // bytes of binary that follow
+};
+
+static const uint32_t CACHE_MAGIC = 0x42435044; // "DPCB"
+static const uint32_t CACHE_VERSION = 3;
+
+static std::string gCacheDir = "cache";
+static ProgramCacheStats gStats;
+
+// 64-bit fnv-1a, continued from h
+static uint64_t fnv1a(const void *data, size_t len, uint64_t h)
+{
+  const unsigned char *p = (const unsigned char *)data;
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+static std::string cachePath(uint64_t key)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+  return (std::filesystem::path(gCacheDir) / name).string();
+}
+
+bool ProgramBinarySupported()
+{
+  static int supported = -1;
+  if (supported < 0)
+  {
+    GLint formats = 0;
+    if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    supported = formats > 0;
+  }
+  return supported == 1;
+}
+
+void SetProgramCacheDir(const std::string &dir)
+{
+  gCacheDir = dir;
+}
+
+uint64_t ProgramCacheDriverKey()
+{
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+  {
+    const char *str = (const char *)glGetString(name);
+    const std::string value = str ? str : "";
+    h = fnv1a(value.c_str(), value.size() + 1, h);
+  }
+  return h;
+}
+
+uint64_t ProgramCacheKey(std::initializer_list<uint64_t> hashes)
+{
+  return ProgramCacheKey(hashes, ProgramCacheDriverKey());
+}
+
+uint64_t ProgramCacheKey(std::initializer_list<uint64_t> hashes, uint64_t driverKey)
+{
+  // pieces are already hashed, only the fixed-size hashes are mixed here
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (uint64_t piece : hashes)
+    h = fnv1a(&piece, sizeof(piece), h);
+  return fnv1a(&driverKey, sizeof(driverKey), h);
+}
+
+GLuint LoadCachedProgram(uint64_t key)
+{
+  if (!ProgramBinarySupported())
+    return 0;
+
+  std::ifstream in(cachePath(key), std::ios::binary);
+  CacheHeader header;
+  if (!in || !in.read((char *)&header, sizeof(header)) || header.magic != CACHE_MAGIC ||
+      header.version != CACHE_VERSION || header.key != key)
+  {
+    gStats.misses++;
+    return 0;
+  }
+
+  // the length comes from disk: a corrupt entry must match the bytes actually left before
+  // it sizes the read
+  const std::streamoff start = in.tellg();
+  in.seekg(0, std::ios::end);
+  const std::streamoff remaining = in.tellg() - start;
+  in.seekg(start);
+  if (header.length == 0 || remaining != (std::streamoff)header.length)
+  {
+    gStats.misses++;
+    return 0;
+  }
+
+  std::vector<char> binary(header.length);
+  if (!in.read(binary.data(), binary.size()))
+  {
+    gStats.misses++;
+    return 0;
+  }
+
+  // the driver may still refuse the blob (different build, changed state), then recompile
+  GLuint prog = glCreateProgram();
+  glProgramBinary(prog, header.format, binary.data(), (GLsizei)binary.size());
+  GLint ok = GL_FALSE;
+  glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+  if (!ok)
+  {
+    glDeleteProgram(prog);
+    gStats.misses++;
+    return 0;
+  }
+
+  gStats.hits++;
+  return prog;
+}
+
+void StoreCachedProgram(uint64_t key, GLuint program)
+{
+  if (!ProgramBinarySupported())
+    return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  std::error_code ec;
+  std::filesystem::create_directories(gCacheDir, ec);
+  if (ec)
+    return;
+
+  // write to a temporary file and rename, so a crash never leaves half an entry
+  const std::string path = cachePath(key);
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    const CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, key, (uint32_t)format, (uint32_t)length};
+    out.write((const char *)&header, sizeof(header));
+    out.write(binary.data(), length);
+    if (!out)
+      return;
+  }
+  std::filesystem::rename(tmp, path, ec);
+}
+
+ProgramCacheStats GetProgramCacheStats()
+{
+  return gStats;
+}
@@ -266,6 +266,12 @@ void QuadMesh::CreateMeshVBO(int /*meshSize*/, GLint attribVertexPosition, GLint
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 	vboReady = true;
+
+	// record the buffers, pointers and enabled attributes once, so the render queue only
+	// binds the vao
+	if (vao)
+		glDeleteVertexArrays(1, &vao);
+	vao = RenderQueue::CreateVertexArray(Layout());
 }
 
 // draw mesh using vbos (vertex attribs must be enabled by shader)
@@ -300,6 +306,22 @@ void QuadMesh::DrawMeshVBO(int /*meshSize*/)
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+// separate position and normal buffers, quads indexed from the ebo
+RenderMesh QuadMesh::Layout() const
+{
+	RenderMesh mesh;
+	if (!vboReady)
+		return mesh;
+	mesh.streams[0] = {vbos[0], (GLuint)attrPos, 3, 0, 0};
+	mesh.streams[1] = {vbos[1], (GLuint)attrNorm, 3, 0, 0};
+	mesh.streamCount = 2;
+	mesh.indexBuffer = vbos[2];
+	mesh.indexCount = (GLsizei)indices.size();
+	mesh.mode = GL_QUADS;
+	mesh.vao = vao;
+	return mesh;
+}
+
 // convenience: create a single quad unit panel centered at origin
 QuadMesh *QuadMesh::MakeUnitPanel()
 {
@@ -0,0 +1,299 @@
+#include "RenderQueue.h"
+#include "FrameUniforms.h"
+#include "ShaderProgram.h"
+#include <cstring>
+
+// key field widths (see RenderQueue.h)
+static const int kIdBits = 12;			// material and mesh ids
+static const int kProgramBits = 6;	// program ids
+static const int kDepthBits = 32;		// float bits of the distance to the eye
+static const uint32_t kMaxIds = 1u << kIdBits;
+static const uint32_t kMaxPrograms = 1u << kProgramBits;
+
+// bit pattern of a non-negative float, ordered like the float
+static uint32_t depthBits(float depth)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits;
+}
+
+void RenderQueue::Begin(const glm::vec3 &e)
+{
+	eye = e;
+	programs.clear();
+	materials.clear();
+	meshes.clear();
+	draws.clear();
+	keys.clear();
+	order.clear();
+}
+
+uint32_t RenderQueue::AddProgram(ShaderProgram &prog, BindFn onBind)
+{
+	programs.push_back({&prog, std::move(onBind)});
+	return (uint32_t)programs.size() - 1;
+}
+
+uint32_t RenderQueue::AddMesh(const RenderMesh &mesh)
+{
+	meshes.push_back(mesh);
+	return (uint32_t)meshes.size() - 1;
+}
+
+uint32_t RenderQueue::Material(const RenderMaterial &mat)
+{
+	// a frame only has a handful of materials, a linear search beats hashing them
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		const RenderMaterial &m = materials[i];
+		if (m.ambient == mat.ambient && m.diffuse == mat.diffuse && m.specular == mat.specular && m.shininess == mat.shininess)
+			return (uint32_t)i;
+	}
+	materials.push_back(mat);
+	return (uint32_t)materials.size() - 1;
+}
+
+bool RenderQueue::MakeKey(RenderPass pass, uint32_t program, uint32_t material, uint32_t mesh, const glm::mat4 &model,
+												  uint64_t &key) const
+{
+	// ids past the key fields or the tables are dropped rather than aliasing another draw
+	if (program >= programs.size() || program >= kMaxPrograms || material >= materials.size() ||
+			material >= kMaxIds || mesh >= meshes.size() || mesh >= kMaxIds)
+		return false;
+	if (!programs[program].prog->program || !meshes[mesh].indexCount)
+		return false; // failed program or empty mesh, nothing would be drawn
+
+	const uint64_t depth = depthBits(glm::distance(eye, glm::vec3(model[3])));
+	const uint64_t state = ((uint64_t)program << (2 * kIdBits)) | ((uint64_t)material << kIdBits) | mesh;
+	key = (uint64_t)pass << 62;
+	if (pass == PASS_BLENDED)
+		key |= ((~depth & 0xffffffffull) << (kProgramBits + 2 * kIdBits)) | state; // far to near
+	else
+		key |= (state << kDepthBits) | depth; // by state, near to far within a state
+	return true;
+}
+
+void RenderQueue::Submit(RenderPass pass, uint32_t program, uint32_t material, uint32_t mesh, const glm::mat4 &model,
+												 GLuint query)
+{
+	uint64_t key;
+	if (!MakeKey(pass, program, material, mesh, model, key))
+		return;
+	keys.push_back(key);
+	order.push_back((uint32_t)draws.size());
+	draws.push_back({model, mesh, material, program, query});
+}
+
+void RenderQueue::List::Begin(const RenderQueue &q)
+{
+	queue = &q;
+	keys.clear();
+	draws.clear();
+}
+
+void RenderQueue::List::Submit(RenderPass pass, uint32_t program, uint32_t material, uint32_t mesh,
+															 const glm::mat4 &model, GLuint query)
+{
+	uint64_t key;
+	if (!queue->MakeKey(pass, program, material, mesh, model, key))
+		return;
+	keys.push_back(key);
+	draws.push_back({model, mesh, material, program, query});
+}
+
+void RenderQueue::Append(const List &list)
+{
+	for (size_t i = 0; i < list.draws.size(); i++)
+	{
+		keys.push_back(list.keys[i]);
+		order.push_back((uint32_t)draws.size());
+		draws.push_back(list.draws[i]);
+	}
+}
+
+void RenderQueue::Sort()
+{
+	const size_t n = keys.size();
+	keysTmp.resize(n);
+	orderTmp.resize(n);
+
+	// one stable counting pass per byte, lowest first; bytes every key shares
+	// (unused ids, the pass for opaque-only frames) are skipped
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t count[256] = {};
+		for (size_t i = 0; i < n; i++)
+			count[(keys[i] >> shift) & 0xff]++;
+		if (count[(keys[0] >> shift) & 0xff] == n)
+			continue;
+
+		size_t offset = 0;
+		for (size_t &c : count)
+		{
+			const size_t next = offset + c;
+			c = offset;
+			offset = next;
+		}
+		for (size_t i = 0; i < n; i++)
+		{
+			const size_t dst = count[(keys[i] >> shift) & 0xff]++;
+			keysTmp[dst] = keys[i];
+			orderTmp[dst] = order[i];
+		}
+		keys.swap(keysTmp);
+		order.swap(orderTmp);
+	}
+}
+
+bool RenderQueue::VertexArraysSupported()
+{
+	return GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object;
+}
+
+GLuint RenderQueue::CreateVertexArray(const RenderMesh &mesh)
+{
+	if (!VertexArraysSupported() || !mesh.indexCount)
+		return 0;
+
+	GLuint vao = 0;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	for (int s = 0; s < mesh.streamCount; s++)
+	{
+		const RenderMesh::Stream &stream = mesh.streams[s];
+		glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+		glVertexAttribPointer(stream.slot, stream.components, GL_FLOAT, GL_FALSE, stream.stride, (void *)stream.offset);
+		glEnableVertexAttribArray(stream.slot);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return vao;
+}
+
+void RenderQueue::BindArrayBuffer(GLuint buffer)
+{
+	if (bound.arrayBuffer == buffer)
+		return;
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	bound.arrayBuffer = buffer;
+}
+
+void RenderQueue::BindMesh(const RenderMesh &mesh)
+{
+	if (mesh.vao)
+	{
+		// everything below lives in the vertex array object
+		if (bound.vao != mesh.vao)
+			glBindVertexArray(mesh.vao);
+		bound.vao = mesh.vao;
+		return;
+	}
+	if (bound.vao)
+	{
+		glBindVertexArray(0);
+		bound.vao = 0;
+	}
+
+	uint32_t slots = 0;
+	for (int s = 0; s < mesh.streamCount; s++)
+	{
+		const RenderMesh::Stream &stream = mesh.streams[s];
+		BindArrayBuffer(stream.buffer);
+		glVertexAttribPointer(stream.slot, stream.components, GL_FLOAT, GL_FALSE, stream.stride, (void *)stream.offset);
+		if (!(bound.slots & (1u << stream.slot)))
+			glEnableVertexAttribArray(stream.slot);
+		slots |= 1u << stream.slot;
+	}
+	const uint32_t stale = bound.slots & ~slots;
+	for (GLuint slot = 0; slot < 32; slot++)
+		if (stale & (1u << slot))
+			glDisableVertexAttribArray(slot);
+	bound.slots = slots;
+	if (bound.elementBuffer != mesh.indexBuffer)
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	bound.elementBuffer = mesh.indexBuffer;
+}
+
+void RenderQueue::Execute(const FrameUniforms &frame)
+{
+	stats = Stats();
+	if (!keys.empty())
+		Sort();
+
+	const uint32_t none = ~0u;
+	uint32_t pass = none, program = none, material = none, mesh = none;
+	ShaderProgram *prog = nullptr;
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		const Draw &d = draws[order[i]];
+
+		const uint32_t drawPass = (uint32_t)(keys[i] >> 62);
+		if (drawPass != pass)
+		{
+			if (drawPass == PASS_BLENDED)
+			{
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			}
+			else
+				glDisable(GL_BLEND);
+			const GLboolean write = drawPass == PASS_OCCLUSION ? GL_FALSE : GL_TRUE;
+			glColorMask(write, write, write, write);
+			glDepthMask(write);
+			pass = drawPass;
+		}
+
+		if (d.program != program)
+		{
+			prog = programs[d.program].prog;
+			if (bound.program != prog->program)
+				glUseProgram(prog->program);
+			bound.program = prog->program;
+			frame.Apply(*prog);
+			if (programs[d.program].onBind)
+				programs[d.program].onBind(*prog);
+			program = d.program;
+			material = none; // uniforms belong to the program
+			stats.programs++;
+		}
+
+		if (d.material != material)
+		{
+			const RenderMaterial &m = materials[d.material];
+			prog->Set("uMat.ambient", m.ambient);
+			prog->Set("uMat.diffuse", m.diffuse);
+			prog->Set("uMat.specular", m.specular);
+			prog->Set("uMat.shininess", m.shininess);
+			material = d.material;
+			stats.materials++;
+		}
+
+		if (d.mesh != mesh)
+		{
+			BindMesh(meshes[d.mesh]);
+			mesh = d.mesh;
+			stats.meshes++;
+		}
+
+		prog->Set("uModel", d.model);
+		prog->Set("uNormalMatrix", glm::mat3(glm::transpose(glm::inverse(d.model))));
+		const RenderMesh &m = meshes[d.mesh];
+		if (d.query)
+			glBeginQuery(GL_SAMPLES_PASSED, d.query);
+		glDrawElements(m.mode, m.indexCount, GL_UNSIGNED_INT, (void *)0);
+		if (d.query)
+			glEndQuery(GL_SAMPLES_PASSED);
+		stats.draws++;
+	}
+
+	// leave no queue state behind for fixed-function drawing
+	BindMesh(RenderMesh());
+	BindArrayBuffer(0);
+	glDisable(GL_BLEND);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glUseProgram(0);
+	bound.program = 0;
+}
@@ -0,0 +1,253 @@
+#include "ShaderProgram.h"
+#include "FrameUniforms.h"
+#include <cstring>
+
+// 32-bit fnv-1a of a uniform or attribute name
+static uint32_t nameHash(const char *name)
+{
+	uint32_t h = 2166136261u;
+	for (const char *p = name; *p; p++)
+	{
+		h ^= (unsigned char)*p;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// 32-bit words per element of a uniform type, 0 for types Set doesn't handle
+static uint32_t typeWords(GLenum type, bool &integer)
+{
+	integer = false;
+	switch (type)
+	{
+	case GL_FLOAT:
+		return 1;
+	case GL_FLOAT_VEC2:
+		return 2;
+	case GL_FLOAT_VEC3:
+		return 3;
+	case GL_FLOAT_VEC4:
+	case GL_FLOAT_MAT2:
+		return 4;
+	case GL_FLOAT_MAT3:
+		return 9;
+	case GL_FLOAT_MAT4:
+		return 16;
+	case GL_INT:
+	case GL_BOOL:
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_SHADOW:
+		integer = true;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// smallest power of two table with at most half its slots in use
+static size_t tableSize(GLint count)
+{
+	size_t n = 8;
+	while (n < (size_t)count * 2)
+		n <<= 1;
+	return n;
+}
+
+ShaderProgram::ShaderProgram(GLuint linked)
+		: program(linked)
+{
+	if (!program)
+		return;
+
+	GLint count = 0, maxLen = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLen);
+	std::vector<char> name(maxLen > 0 ? maxLen : 1);
+
+	uniforms.resize(tableSize(count));
+	for (GLint i = 0; i < count; i++)
+	{
+		Slot s;
+		glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), nullptr, &s.size, &s.type, name.data());
+		if (!strncmp(name.data(), "gl_", 3))
+			continue; // built-in state, not settable
+
+		// arrays are reported as "name[0]", keep the plain name
+		const size_t len = strlen(name.data());
+		if (len > 3 && !strcmp(name.data() + len - 3, "[0]"))
+			name[len - 3] = '\0';
+
+		// members of uniform blocks have no location, the block buffer feeds them
+		s.location = glGetUniformLocation(program, name.data());
+		if (s.location < 0)
+			continue;
+
+		s.name = name.data();
+		s.hash = nameHash(name.data());
+		s.components = typeWords(s.type, s.integer);
+		s.offset = (uint32_t)shadow.size();
+		shadow.resize(shadow.size() + s.components * (size_t)s.size);
+		Insert(uniforms, s);
+	}
+
+	// shared per-frame block reads from its fixed binding (see FrameUniforms.h)
+	if (FrameUniforms::Supported())
+	{
+		const GLuint block = glGetUniformBlockIndex(program, FRAME_BLOCK_NAME);
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, block, FRAME_BLOCK_BINDING);
+	}
+
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLen);
+	name.resize(maxLen > 0 ? maxLen : 1);
+
+	attributes.resize(tableSize(count));
+	for (GLint i = 0; i < count; i++)
+	{
+		Slot s;
+		glGetActiveAttrib(program, (GLuint)i, (GLsizei)name.size(), nullptr, &s.size, &s.type, name.data());
+		if (!strncmp(name.data(), "gl_", 3))
+			continue;
+		s.name = name.data();
+		s.hash = nameHash(name.data());
+		s.location = glGetAttribLocation(program, name.data());
+		Insert(attributes, s);
+	}
+}
+
+void ShaderProgram::Insert(std::vector<Slot> &table, const Slot &slot)
+{
+	const size_t mask = table.size() - 1;
+	size_t i = slot.hash & mask;
+	while (!table[i].name.empty())
+		i = (i + 1) & mask;
+	table[i] = slot;
+}
+
+int ShaderProgram::Find(const std::vector<Slot> &table, const char *name)
+{
+	if (table.empty())
+		return -1;
+
+	const uint32_t h = nameHash(name);
+	const size_t mask = table.size() - 1;
+	for (size_t i = h & mask;; i = (i + 1) & mask)
+	{
+		const Slot &s = table[i];
+		if (s.name.empty())
+			return -1;
+		if (s.hash == h && s.name == name)
+			return (int)i;
+	}
+}
+
+GLint ShaderProgram::Uniform(const char *name) const
+{
+	// "name[0]" finds the array's plain entry
+	const size_t len = strlen(name);
+	if (len > 3 && !strcmp(name + len - 3, "[0]"))
+		return Uniform(std::string(name, len - 3).c_str());
+
+	const int i = Find(uniforms, name);
+	return i < 0 ? -1 : uniforms[i].location;
+}
+
+GLint ShaderProgram::Attribute(const char *name) const
+{
+	const int i = Find(attributes, name);
+	return i < 0 ? -1 : attributes[i].location;
+}
+
+void ShaderProgram::Store(const char *name, const void *words, uint32_t elementWords, int count, bool integer)
+{
+	const int i = Find(uniforms, name);
+	if (i < 0)
+		return;
+	Slot &s = uniforms[i];
+	if (!s.components || s.integer != integer || count < 1 || count > s.size ||
+			(elementWords && elementWords != s.components))
+		return;
+
+	// same value as last time: the program already has it
+	const uint32_t n = s.components * (uint32_t)count;
+	uint32_t *cached = shadow.data() + s.offset;
+	if (n <= s.known && !memcmp(cached, words, n * sizeof(uint32_t)))
+		return;
+	memcpy(cached, words, n * sizeof(uint32_t));
+	s.known = n > s.known ? n : s.known;
+
+	const GLfloat *f = (const GLfloat *)words;
+	const GLint *k = (const GLint *)words;
+	switch (s.type)
+	{
+	case GL_FLOAT:
+		glUniform1fv(s.location, count, f);
+		break;
+	case GL_FLOAT_VEC2:
+		glUniform2fv(s.location, count, f);
+		break;
+	case GL_FLOAT_VEC3:
+		glUniform3fv(s.location, count, f);
+		break;
+	case GL_FLOAT_VEC4:
+		glUniform4fv(s.location, count, f);
+		break;
+	case GL_FLOAT_MAT2:
+		glUniformMatrix2fv(s.location, count, GL_FALSE, f);
+		break;
+	case GL_FLOAT_MAT3:
+		glUniformMatrix3fv(s.location, count, GL_FALSE, f);
+		break;
+	case GL_FLOAT_MAT4:
+		glUniformMatrix4fv(s.location, count, GL_FALSE, f);
+		break;
+	default:
+		glUniform1iv(s.location, count, k);
+		break;
+	}
+}
+
+void ShaderProgram::Set(const char *name, GLint v)
+{
+	Store(name, &v, 1, 1, true);
+}
+
+void ShaderProgram::Set(const char *name, float v)
+{
+	Store(name, &v, 1, 1, false);
+}
+
+void ShaderProgram::Set(const char *name, const glm::vec3 &v)
+{
+	Store(name, &v[0], 3, 1, false);
+}
+
+void ShaderProgram::Set(const char *name, const glm::vec4 &v)
+{
+	Store(name, &v[0], 4, 1, false);
+}
+
+void ShaderProgram::Set(const char *name, const glm::mat3 &m)
+{
+	Store(name, &m[0][0], 9, 1, false);
+}
+
+void ShaderProgram::Set(const char *name, const glm::mat4 &m)
+{
+	Store(name, &m[0][0], 16, 1, false);
+}
+
+void ShaderProgram::Set(const char *name, const float *v, int count)
+{
+	Store(name, v, 0, count, false);
+}
+
+void ShaderProgram::Invalidate()
+{
+	for (Slot &s : uniforms)
+		s.known = 0;
+}
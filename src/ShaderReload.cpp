@@ -0,0 +1,246 @@
+#include "ShaderReload.h"
+#include "EmbeddedShaders.h"
+#include "ShaderUtils.h"
+#include "ProgramCache.h"
+#include <cstdio>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// without inotify, file times are checked every this many polls (about 0.5 s of frames)
+static const unsigned kStatInterval = 30;
+
+static std::filesystem::file_time_type fileTime(const std::string &path)
+{
+	std::error_code ec;
+	const std::filesystem::file_time_type t = std::filesystem::last_write_time(path, ec);
+	return ec ? std::filesystem::file_time_type() : t;
+}
+
+// "scene.vert + scene.frag", plus the macro names of a variant
+static std::string entryName(const std::string &vsFile, const std::string &fsFile, const std::string &defines)
+{
+	std::string name = vsFile + " + " + fsFile;
+	for (size_t at = defines.find("#define "); at != std::string::npos; at = defines.find("#define ", at + 1))
+		name += " " + defines.substr(at + 8, defines.find_first_of(" \n", at + 8) - at - 8);
+	return name;
+}
+
+ShaderReloader::ShaderReloader(const std::string &shaderDir)
+		: dir(shaderDir)
+{
+	// let the driver compile on its own threads; completion is then queried without blocking
+	parallelCompile = EnableParallelShaderCompile();
+
+#ifdef __linux__
+	// close-write catches editors saving in place, moved-to the ones that rename a temp file
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifyFd >= 0 && inotify_add_watch(notifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(notifyFd);
+		notifyFd = -1;
+	}
+#endif
+}
+
+ShaderReloader::~ShaderReloader()
+{
+	for (Entry &e : entries)
+		Drop(e);
+#ifdef __linux__
+	if (notifyFd >= 0)
+		close(notifyFd);
+#endif
+}
+
+void ShaderReloader::Watch(const std::string &vsFile, const std::string &fsFile, GLuint program, SwapFn onSwap,
+													const std::string &defines)
+{
+	Entry e;
+	e.vsFile = vsFile;
+	e.fsFile = fsFile;
+	e.defines = defines;
+	e.program = program;
+	e.onSwap = onSwap;
+
+	// remember what is running so saving unchanged text doesn't rebuild
+	std::string vsSrc, fsSrc;
+	if (program)
+		Load(e, vsSrc, fsSrc, e.key);
+
+	e.vsTime = fileTime(dir + vsFile);
+	e.fsTime = fileTime(dir + fsFile);
+	entries.push_back(e);
+}
+
+bool ShaderReloader::Load(const Entry &e, std::string &vsSrc, std::string &fsSrc, uint64_t &key) const
+{
+	if (!LoadTextFile(dir + e.vsFile, vsSrc) || !LoadTextFile(dir + e.fsFile, fsSrc))
+		return false;
+	// same key ShaderVariants gives these sources
+	key = ProgramCacheKey({ShaderSourceHash(vsSrc), ShaderSourceHash(fsSrc), ShaderSourceHash(e.defines)});
+	vsSrc = InjectDefines(vsSrc, e.defines);
+	fsSrc = InjectDefines(fsSrc, e.defines);
+	return true;
+}
+
+void ShaderReloader::CollectChanges()
+{
+#ifdef __linux__
+	if (notifyFd >= 0)
+	{
+		alignas(struct inotify_event) char buf[4096];
+		ssize_t len;
+		while ((len = read(notifyFd, buf, sizeof(buf))) > 0)
+		{
+			for (char *p = buf; p < buf + len;)
+			{
+				const struct inotify_event *ev = (const struct inotify_event *)p;
+				if (ev->len > 0)
+				{
+					const std::string name = ev->name;
+					for (Entry &e : entries)
+						if (e.vsFile == name || e.fsFile == name)
+							e.changed = true;
+				}
+				p += sizeof(struct inotify_event) + ev->len;
+			}
+		}
+		return;
+	}
+#endif
+
+	if (pollCount % kStatInterval != 0)
+		return;
+	for (Entry &e : entries)
+	{
+		const std::filesystem::file_time_type vsTime = fileTime(dir + e.vsFile);
+		const std::filesystem::file_time_type fsTime = fileTime(dir + e.fsFile);
+		if (vsTime != e.vsTime || fsTime != e.fsTime)
+		{
+			e.vsTime = vsTime;
+			e.fsTime = fsTime;
+			e.changed = true;
+		}
+	}
+}
+
+bool ShaderReloader::Poll()
+{
+	pollCount++;
+	CollectChanges();
+
+	bool swapped = false;
+	for (Entry &e : entries)
+	{
+		if (e.changed)
+		{
+			e.changed = false;
+			Start(e);
+		}
+		else if (e.pending)
+		{
+			e.pendingPolls++;
+			if (Ready(e))
+			{
+				const GLuint live = e.program;
+				Finish(e);
+				swapped |= e.program != live;
+			}
+		}
+	}
+	return swapped;
+}
+
+void ShaderReloader::Start(Entry &e)
+{
+	std::string vsSrc, fsSrc;
+	uint64_t key = 0;
+	if (!Load(e, vsSrc, fsSrc, key))
+		return; // mid-save, the rename that follows triggers another change
+
+	// nothing new (file touched, or saved back to what is running / already building)
+	if (e.pending ? key == e.pendingKey : key == e.key)
+		return;
+	Drop(e);
+	if (key == e.key)
+		return;
+
+	// a version seen before (e.g. an edit undone) comes straight from the binary cache
+	GLuint cached = LoadCachedProgram(key);
+	if (cached)
+	{
+		Swap(e, cached, key);
+		return;
+	}
+
+	// only issue the work here, status is checked on a later poll
+	e.pendingVs = BeginCompileShader(GL_VERTEX_SHADER, vsSrc);
+	e.pendingFs = BeginCompileShader(GL_FRAGMENT_SHADER, fsSrc);
+	e.pending = BeginLinkProgram(e.pendingVs, e.pendingFs);
+	e.pendingKey = key;
+	e.pendingPolls = 0;
+}
+
+bool ShaderReloader::Ready(const Entry &e) const
+{
+	if (parallelCompile)
+	{
+		GLint done = GL_FALSE;
+		glGetProgramiv(e.pending, GL_COMPLETION_STATUS_KHR, &done);
+		return done == GL_TRUE;
+	}
+	// no completion query: nothing tells when the build is done, so after one frame the
+	// status query in Finish blocks until it is (a frame hitch per rebuilt program)
+	return e.pendingPolls >= 1;
+}
+
+void ShaderReloader::Finish(Entry &e)
+{
+	std::string err;
+	GLuint program = e.pending;
+	e.pending = 0;
+
+	bool ok = FinishCompileShader(e.pendingVs, dir + e.vsFile, &err) &&
+						FinishCompileShader(e.pendingFs, dir + e.fsFile, &err);
+	if (ok)
+		ok = FinishLinkProgram(program, &err);
+	else
+		glDeleteProgram(program);
+
+	glDeleteShader(e.pendingVs);
+	glDeleteShader(e.pendingFs);
+	e.pendingVs = e.pendingFs = 0;
+
+	if (!ok)
+	{
+		fprintf(stderr, "Reload of %s failed, keeping the running program:\n%s\n",
+						entryName(e.vsFile, e.fsFile, e.defines).c_str(), err.c_str());
+		return;
+	}
+
+	StoreCachedProgram(e.pendingKey, program);
+	Swap(e, program, e.pendingKey);
+}
+
+void ShaderReloader::Drop(Entry &e)
+{
+	if (!e.pending)
+		return;
+	glDeleteProgram(e.pending);
+	glDeleteShader(e.pendingVs);
+	glDeleteShader(e.pendingFs);
+	e.pending = e.pendingVs = e.pendingFs = 0;
+}
+
+void ShaderReloader::Swap(Entry &e, GLuint program, uint64_t key)
+{
+	e.onSwap(program);
+	if (e.program)
+		glDeleteProgram(e.program);
+	e.program = program;
+	e.key = key;
+	fprintf(stdout, "Reloaded %s.\n", entryName(e.vsFile, e.fsFile, e.defines).c_str());
+}
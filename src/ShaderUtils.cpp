@@ -1,9 +1,15 @@
 #include "ShaderUtils.h"
+#include "EmbeddedShaders.h"
+#include "ProgramCache.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
 // utility functions for loading and compiling opengl shaders
 
+// directory overriding the embedded sources ("" = embedded only)
+static std::string gShaderDir;
+
 // load a text file into out, return true on success
 bool LoadTextFile(const std::string &path, std::string &out)
 {
@@ -18,25 +24,60 @@ bool LoadTextFile(const std::string &path, std::string &out)
   return true;
 }
 
-// compile a shader from a file path and return the shader object (or 0 on error)
-// if err is provided, fill it with a human-readable error message
-GLuint CompileShaderFromFile(GLenum type, const std::string &path, std::string *err)
+// binary search of the generated table (sorted by name)
+const EmbeddedShader *FindEmbeddedShader(const std::string &name)
+{
+  const EmbeddedShader *end = EMBEDDED_SHADERS + EMBEDDED_SHADER_COUNT;
+  const EmbeddedShader *it = std::lower_bound(EMBEDDED_SHADERS, end, name, [](const EmbeddedShader &s, const std::string &n)
+                                              { return n.compare(s.name) > 0; });
+  return it != end && name == it->name ? it : nullptr;
+}
+
+void SetShaderDir(const std::string &dir)
 {
-  std::string src;
-  if (!LoadTextFile(path, src))
+  gShaderDir = dir.empty() || dir.back() == '/' ? dir : dir + "/";
+}
+
+const std::string &ShaderDir()
+{
+  return gShaderDir;
+}
+
+// source of a shader by file name: the override directory's file when one is set and
+// readable, else the copy built into the executable (no file i/o, hash precomputed)
+bool LoadShaderSource(const std::string &name, std::string &out, uint64_t *hash)
+{
+  if (!gShaderDir.empty() && LoadTextFile(gShaderDir + name, out))
   {
-    if (err)
-      *err = "Failed to read: " + path;
-    return 0;
+    if (hash)
+      *hash = ShaderSourceHash(out);
+    return true;
   }
 
+  const EmbeddedShader *shader = FindEmbeddedShader(name);
+  if (!shader)
+    return false;
+  out.assign(shader->source, shader->length);
+  if (hash)
+    *hash = shader->hash;
+  return true;
+}
+
+// create a shader object and start compiling src without waiting for the result
+GLuint BeginCompileShader(GLenum type, const std::string &src)
+{
   // create shader object and set source
   GLuint sh = glCreateShader(type);
   const char *csrc = src.c_str();
   glShaderSource(sh, 1, &csrc, nullptr);
-
-  // compile and check status
   glCompileShader(sh);
+  return sh;
+}
+
+// wait for a shader started with BeginCompileShader and check its status
+// on failure fill err with the compile log (name labels the message)
+bool FinishCompileShader(GLuint sh, const std::string &name, std::string *err)
+{
   GLint ok = GL_FALSE;
   glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
   if (!ok)
@@ -47,94 +88,82 @@ GLuint CompileShaderFromFile(GLenum type, const std::string &path, std::string *
     std::string log(len, '\0');
     glGetShaderInfoLog(sh, len, nullptr, &log[0]);
     if (err)
-      *err = "Compile error in " + path + ":\n" + log;
-    glDeleteShader(sh);
-    return 0;
+      *err = "Compile error in " + name + ":\n" + log;
+    return false;
   }
-  return sh;
+  return true;
 }
 
-// link vertex and fragment shaders into a program
-// returns true on success and sets outProgram, false on error
-bool LinkProgram(GLuint vs, GLuint fs, GLuint &outProgram, std::string *err)
+// src with lines (e.g. "#define FOG 1\n") inserted after its #version line, or at the
+// top when it has none; the line directive keeps compile errors on the file's numbering
+std::string InjectDefines(const std::string &src, const std::string &defines)
 {
-  outProgram = glCreateProgram();
+  if (defines.empty())
+    return src;
+
+  size_t at = 0, line = 1;
+  if (src.compare(0, 8, "#version") == 0)
+  {
+    at = src.find('\n');
+    at = at == std::string::npos ? src.size() : at + 1;
+    line = 2;
+  }
+  return src.substr(0, at) + defines + "#line " + std::to_string(line) + "\n" + src.substr(at);
+}
+
+// create a program from vs and fs and start linking it without waiting for the result
+GLuint BeginLinkProgram(GLuint vs, GLuint fs)
+{
+  GLuint program = glCreateProgram();
   // attach compiled shader objects
-  glAttachShader(outProgram, vs);
-  glAttachShader(outProgram, fs);
+  glAttachShader(program, vs);
+  glAttachShader(program, fs);
 
   // bind attribute locations before linking so vbo layout is stable
-  glBindAttribLocation(outProgram, 0, "aPos");
-  glBindAttribLocation(outProgram, 1, "aNormal");
+  glBindAttribLocation(program, ATTRIB_POS, "aPos");
+  glBindAttribLocation(program, ATTRIB_NORMAL, "aNormal");
+  glBindAttribLocation(program, ATTRIB_INSTANCE_MODEL, "aInstanceModel");
+  glBindAttribLocation(program, ATTRIB_SURFACE, "aSurface");
+
+  // ask for a retrievable binary so the program cache can store it
+  if (ProgramBinarySupported())
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+  glLinkProgram(program);
+  return program;
+}
 
-  // link program and check for link errors
-  glLinkProgram(outProgram);
+// wait for a program started with BeginLinkProgram and check for link errors
+// on failure the program is deleted, set to 0 and err gets the link log
+bool FinishLinkProgram(GLuint &program, std::string *err)
+{
   GLint ok = GL_FALSE;
-  glGetProgramiv(outProgram, GL_LINK_STATUS, &ok);
+  glGetProgramiv(program, GL_LINK_STATUS, &ok);
   if (!ok)
   {
     // get link log and report it
     GLint len = 0;
-    glGetProgramiv(outProgram, GL_INFO_LOG_LENGTH, &len);
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
     std::string log(len, '\0');
-    glGetProgramInfoLog(outProgram, len, nullptr, &log[0]);
+    glGetProgramInfoLog(program, len, nullptr, &log[0]);
     if (err)
       *err = "Link error:\n" + log;
-    glDeleteProgram(outProgram);
-    outProgram = 0;
+    glDeleteProgram(program);
+    program = 0;
     return false;
   }
   return true;
 }
 
-// helper to create a shader program used for ground rendering
-// compiles vertex + fragment shaders, links them, and fetches attribute/uniform locations
-ShaderProgram MakeGroundProgram(const std::string &vsPath, const std::string &fsPath, std::string *err)
+// let the driver compile and link on its own threads (KHR/ARB_parallel_shader_compile)
+// returns true when GL_COMPLETION_STATUS_KHR can be queried
+bool EnableParallelShaderCompile()
 {
-  ShaderProgram sp;
-
-  // compile vertex shader
-  GLuint vs = CompileShaderFromFile(GL_VERTEX_SHADER, vsPath, err);
-  if (!vs)
-    return sp;
-
-  // compile fragment shader
-  GLuint fs = CompileShaderFromFile(GL_FRAGMENT_SHADER, fsPath, err);
-  if (!fs)
-  {
-    glDeleteShader(vs);
-    return sp;
-  }
-
-  // link into program
-  GLuint prog = 0;
-  if (!LinkProgram(vs, fs, prog, err))
-  {
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    return sp;
-  }
-
-  // shaders no longer needed once linked
-  glDeleteShader(vs);
-  glDeleteShader(fs);
-
-  sp.program = prog;
-
-  // attribute indices we bound before linking
-  sp.attribPos = 0;
-  sp.attribNormal = 1;
-
-  // cache uniform locations for faster use later
-  sp.locModel = glGetUniformLocation(prog, "uModel");
-  sp.locView = glGetUniformLocation(prog, "uView");
-  sp.locProj = glGetUniformLocation(prog, "uProj");
-  sp.locNormalMat = glGetUniformLocation(prog, "uNormalMatrix");
-  sp.locLightPos = glGetUniformLocation(prog, "uLightPos");
-  sp.locViewPos = glGetUniformLocation(prog, "uViewPos");
-  sp.locMatAmbient = glGetUniformLocation(prog, "uMat.ambient");
-  sp.locMatDiffuse = glGetUniformLocation(prog, "uMat.diffuse");
-  sp.locMatSpecular = glGetUniformLocation(prog, "uMat.specular");
-  sp.locMatShininess = glGetUniformLocation(prog, "uMat.shininess");
-  return sp;
+  if (GLEW_KHR_parallel_shader_compile)
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // driver picks the thread count
+  else if (GLEW_ARB_parallel_shader_compile)
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+  else
+    return false;
+  return true;
 }
@@ -0,0 +1,138 @@
+#include "ShaderVariants.h"
+#include "EmbeddedShaders.h"
+#include "JobPool.h"
+#include "ProgramCache.h"
+#include "ShaderReload.h"
+#include "ShaderUtils.h"
+#include <cstdio>
+
+ShaderVariants::ShaderVariants(const std::string &vs, const std::string &fs, const char *const *defines, int featureCount)
+		: vsName(vs), fsName(fs), macros(defines, defines + featureCount), programs((size_t)1 << featureCount),
+			requested((size_t)1 << featureCount, 0)
+{
+}
+
+std::string ShaderVariants::Defines(uint32_t mask) const
+{
+	std::string out;
+	for (size_t i = 0; i < macros.size(); i++)
+		if (mask & (1u << i))
+			out += "#define " + macros[i] + " 1\n";
+	return out;
+}
+
+int ShaderVariants::Build(JobPool &jobs, std::vector<uint32_t> masks)
+{
+	if (masks.empty())
+		for (uint32_t m = 0; m < programs.size(); m++)
+			masks.push_back(m);
+	for (uint32_t &m : masks)
+	{
+		m &= (uint32_t)(programs.size() - 1);
+		requested[m] = 1;
+	}
+	compiled = cached = 0;
+
+	std::string vsSrc, fsSrc;
+	uint64_t vsHash = 0, fsHash = 0;
+	// each source on its own, so the message names the one that is missing
+	const bool vsFound = LoadShaderSource(vsName, vsSrc, &vsHash);
+	if (!vsFound || !LoadShaderSource(fsName, fsSrc, &fsHash))
+	{
+		fprintf(stderr, "No shader named: %s\n", (vsFound ? fsName : vsName).c_str());
+		return (int)masks.size();
+	}
+
+	struct Variant
+	{
+		uint32_t mask = 0;
+		std::string vs, fs;
+		uint64_t key = 0;
+		GLuint vsObj = 0, fsObj = 0, program = 0;
+	};
+	std::vector<Variant> work(masks.size());
+
+	// 1. cache keys from the source hashes (embedded ones were computed at build time)
+	//    and restore the cached binaries
+	const uint64_t driverKey = ProgramCacheDriverKey();
+	std::vector<Variant *> missing;
+	for (size_t i = 0; i < work.size(); i++)
+	{
+		Variant &v = work[i];
+		v.mask = masks[i];
+		v.key = ProgramCacheKey({vsHash, fsHash, ShaderSourceHash(Defines(v.mask))}, driverKey);
+		v.program = LoadCachedProgram(v.key);
+		if (v.program)
+			cached++;
+		else
+			missing.push_back(&v);
+	}
+
+	// 2. sources of the variants left to compile (no gl calls, so this runs on the workers)
+	jobs.ParallelFor(missing.size(), 1, [&](size_t begin, size_t end)
+									 {
+		for (size_t i = begin; i < end; i++)
+		{
+			Variant &v = *missing[i];
+			const std::string defines = Defines(v.mask);
+			v.vs = InjectDefines(vsSrc, defines);
+			v.fs = InjectDefines(fsSrc, defines);
+		} });
+
+	// 3. issue every compile and link without waiting
+	EnableParallelShaderCompile();
+	for (Variant *m : missing)
+	{
+		Variant &v = *m;
+		v.vsObj = BeginCompileShader(GL_VERTEX_SHADER, v.vs);
+		v.fsObj = BeginCompileShader(GL_FRAGMENT_SHADER, v.fs);
+		v.program = BeginLinkProgram(v.vsObj, v.fsObj);
+	}
+
+	// 4. collect: a status query waits for its own variant while the driver keeps
+	//    building the rest on its threads (with parallel compile)
+	int failed = 0;
+	for (Variant &v : work)
+	{
+		if (v.vsObj)
+		{
+			std::string err;
+			bool ok = FinishCompileShader(v.vsObj, vsName, &err) && FinishCompileShader(v.fsObj, fsName, &err);
+			if (ok)
+				ok = FinishLinkProgram(v.program, &err);
+			else
+				glDeleteProgram(v.program);
+			glDeleteShader(v.vsObj);
+			glDeleteShader(v.fsObj);
+
+			if (!ok)
+			{
+				std::string label;
+				for (size_t i = 0; i < macros.size(); i++)
+					if (v.mask & (1u << i))
+						label += (label.empty() ? "" : " ") + macros[i];
+				fprintf(stderr, "Shader variant [%s] failed: %s\n", label.c_str(), err.c_str());
+				failed++;
+				continue;
+			}
+			StoreCachedProgram(v.key, v.program);
+			compiled++;
+		}
+
+		if (programs[v.mask].program)
+			glDeleteProgram(programs[v.mask].program);
+		programs[v.mask] = ShaderProgram(v.program);
+	}
+	return failed;
+}
+
+void ShaderVariants::Watch(ShaderReloader &reloader)
+{
+	for (uint32_t mask = 0; mask < programs.size(); mask++)
+	{
+		if (!requested[mask])
+			continue;
+		reloader.Watch(vsName, fsName, programs[mask].program, [this, mask](GLuint prog)
+									 { programs[mask] = ShaderProgram(prog); }, Defines(mask));
+	}
+}
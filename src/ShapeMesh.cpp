@@ -0,0 +1,139 @@
+#include "ShapeMesh.h"
+#include "ShaderUtils.h"
+#include <cmath>
+#include <cstddef>
+
+static const float kTwoPi = 6.28318530718f;
+
+void ShapeMesh::InitSphere(int slices, int stacks)
+{
+	vertices.clear();
+	indices.clear();
+
+	// rings from the +z pole to the -z pole, the seam column is duplicated
+	for (int j = 0; j <= stacks; j++)
+	{
+		const float polar = 0.5f * kTwoPi * (float)j / (float)stacks;
+		for (int i = 0; i <= slices; i++)
+		{
+			const float azimuth = kTwoPi * (float)i / (float)slices;
+			const glm::vec3 p(std::sin(polar) * std::cos(azimuth), std::sin(polar) * std::sin(azimuth), std::cos(polar));
+			vertices.push_back({p, p});
+		}
+	}
+	for (int j = 0; j < stacks; j++)
+	{
+		for (int i = 0; i < slices; i++)
+		{
+			const unsigned int a = j * (slices + 1) + i, b = a + slices + 1;
+			indices.insert(indices.end(), {a, b, b + 1, a, b + 1, a + 1});
+		}
+	}
+	Upload();
+}
+
+void ShapeMesh::InitCone(int slices, int stacks)
+{
+	vertices.clear();
+	indices.clear();
+
+	// side: radius shrinks from 1 to 0 over the stacks, normals lean up by 45 degrees
+	// (base radius equals height); the apex ring keeps one vertex per slice for its normal
+	for (int j = 0; j <= stacks; j++)
+	{
+		const float t = (float)j / (float)stacks;
+		for (int i = 0; i <= slices; i++)
+		{
+			const float azimuth = kTwoPi * (float)i / (float)slices;
+			const float c = std::cos(azimuth), s = std::sin(azimuth);
+			vertices.push_back({glm::vec3(c * (1.0f - t), s * (1.0f - t), t), glm::normalize(glm::vec3(c, s, 1.0f))});
+		}
+	}
+	for (int j = 0; j < stacks; j++)
+	{
+		for (int i = 0; i < slices; i++)
+		{
+			const unsigned int a = j * (slices + 1) + i, b = a + slices + 1;
+			indices.insert(indices.end(), {a, a + 1, b + 1, a, b + 1, b});
+		}
+	}
+
+	// base cap facing -z
+	const unsigned int center = (unsigned int)vertices.size();
+	vertices.push_back({glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f)});
+	for (int i = 0; i <= slices; i++)
+	{
+		const float azimuth = kTwoPi * (float)i / (float)slices;
+		vertices.push_back({glm::vec3(std::cos(azimuth), std::sin(azimuth), 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)});
+	}
+	for (int i = 0; i < slices; i++)
+		indices.insert(indices.end(), {center, center + 2 + i, center + 1 + i});
+	Upload();
+}
+
+void ShapeMesh::InitBox()
+{
+	vertices.clear();
+	indices.clear();
+
+	// one face per axis direction, corners counter-clockwise seen from outside
+	const glm::vec3 normals[6] = {{0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+	for (const glm::vec3 &n : normals)
+	{
+		// two axes spanning the face, u x v = n
+		const glm::vec3 u = n.x != 0.0f ? glm::vec3(0.0f, 0.0f, -n.x) : glm::vec3(n.y + n.z, 0.0f, 0.0f);
+		const glm::vec3 v = glm::cross(n, u);
+		const unsigned int a = (unsigned int)vertices.size();
+		vertices.push_back({(n - u - v) * 0.5f, n});
+		vertices.push_back({(n + u - v) * 0.5f, n});
+		vertices.push_back({(n + u + v) * 0.5f, n});
+		vertices.push_back({(n - u + v) * 0.5f, n});
+		indices.insert(indices.end(), {a, a + 1, a + 2, a, a + 2, a + 3});
+	}
+	Upload();
+}
+
+void ShapeMesh::InitQuad()
+{
+	vertices.clear();
+	indices.clear();
+
+	const glm::vec3 n(0.0f, 0.0f, 1.0f);
+	vertices.push_back({glm::vec3(-1.0f, -1.0f, 0.0f), n});
+	vertices.push_back({glm::vec3(1.0f, -1.0f, 0.0f), n});
+	vertices.push_back({glm::vec3(1.0f, 1.0f, 0.0f), n});
+	vertices.push_back({glm::vec3(-1.0f, 1.0f, 0.0f), n});
+	indices = {0, 1, 2, 0, 2, 3};
+	Upload();
+}
+
+void ShapeMesh::Upload()
+{
+	if (!vbos[0])
+		glGenBuffers(2, vbos);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(MeshVertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	if (!vao)
+		vao = RenderQueue::CreateVertexArray(Layout());
+}
+
+RenderMesh ShapeMesh::Layout() const
+{
+	RenderMesh mesh;
+	if (!vbos[0])
+		return mesh;
+	mesh.streams[0] = {vbos[0], ATTRIB_POS, 3, sizeof(MeshVertex), offsetof(MeshVertex, position)};
+	mesh.streams[1] = {vbos[0], ATTRIB_NORMAL, 3, sizeof(MeshVertex), offsetof(MeshVertex, normal)};
+	mesh.streamCount = 2;
+	mesh.indexBuffer = vbos[1];
+	mesh.indexCount = (GLsizei)indices.size();
+	mesh.vao = vao;
+	return mesh;
+}
@@ -0,0 +1,99 @@
+#include "StreamBuffer.h"
+
+StreamBuffer::~StreamBuffer()
+{
+	for (GLsync &fence : fences)
+		if (fence)
+			glDeleteSync(fence);
+	if (buffer)
+		glDeleteBuffers(1, &buffer); // unmaps too
+}
+
+bool StreamBuffer::PersistentSupported()
+{
+	return GLEW_VERSION_4_4 || (GLEW_ARB_buffer_storage && (GLEW_VERSION_3_2 || GLEW_ARB_sync));
+}
+
+void StreamBuffer::Init(size_t bytesPerFrame)
+{
+	frameBytes = bytesPerFrame;
+
+	if (PersistentSupported())
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferStorage(GL_ARRAY_BUFFER, frameBytes * kFrames, nullptr, flags);
+		mapped = (unsigned char *)glMapBufferRange(GL_ARRAY_BUFFER, 0, frameBytes * kFrames, flags);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		if (!mapped)
+		{
+			// storage is immutable, start over with a plain buffer
+			glDeleteBuffers(1, &buffer);
+			buffer = 0;
+		}
+	}
+
+	if (!mapped)
+	{
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, frameBytes, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		staging.resize(frameBytes);
+	}
+}
+
+void *StreamBuffer::Alloc(size_t bytes, size_t align, GLintptr &offset)
+{
+	const size_t start = (used + align - 1) / align * align;
+	if (!buffer || start + bytes > frameBytes)
+		return nullptr;
+	used = start + bytes;
+
+	if (mapped)
+	{
+		offset = (GLintptr)(frameBytes * frame + start);
+		return mapped + offset;
+	}
+	offset = (GLintptr)start;
+	return staging.data() + start;
+}
+
+void StreamBuffer::Commit(GLintptr offset, size_t bytes)
+{
+	if (mapped)
+		return; // coherent mapping, the gpu sees the writes
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, staging.data() + offset);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::EndFrame()
+{
+	used = 0;
+	if (!buffer)
+		return;
+
+	if (!mapped)
+	{
+		// orphan: draws already issued keep the old storage
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, frameBytes, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return;
+	}
+
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame = (frame + 1) % kFrames;
+	if (fences[frame])
+	{
+		// the gpu finished this region kFrames - 1 frames ago unless it is far behind
+		GLenum status;
+		do
+			status = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+		while (status == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(fences[frame]);
+		fences[frame] = 0;
+	}
+}
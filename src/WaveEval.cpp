@@ -0,0 +1,195 @@
+#include "Duck.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// batched wave height: y = lift + amp * sin(2 pi * (waves * t - speed * time)),
+// t = (x - x0) / (x1 - x0)
+//
+// the sine is a polynomial on the phase in cycles rather than a libm call:
+//   1. p = waves * t - speed * time, f = p - round(p) keeps the fractional cycle in [-0.5, 0.5]
+//   2. sin(2 pi f) = sin(2 pi (+-0.5 - f)) folds f into [-0.25, 0.25] (a quarter turn)
+//   3. odd degree 11 taylor polynomial in f, truncation error < 6e-8 there
+// measured over every float phase of a cycle against a double precision sine of the
+// same phase, the sine stays within 1.8e-7 and the height within 3e-7 * amp (for
+// |lift| <= amp, the rounding of y included) on the sse2, avx2 and scalar paths; x87
+// builds (32-bit without sse) were not measured. a few float ulps, far below anything
+// visible on screen
+//
+// avx2 (8 lanes), sse2 (4 lanes) and scalar paths run the same steps; tails go through
+// the vector kernel on a padded copy, so within a build every x gives the same y no
+// matter where in a batch it sits (waveYAt included)
+//
+// data/shaders/wave.vert runs the same steps on the gpu to animate the water, so ducks
+// placed with these heights sit on the drawn surface (gpu float rounding may differ
+// by a few ulps, around 1e-6 * amp)
+
+// taylor coefficients of sin(2 pi f) in powers of f (f, f^3, ... f^11)
+static const float kSin1 = 6.28318530718f;
+static const float kSin3 = -41.3417022404f;
+static const float kSin5 = 81.6052492761f;
+static const float kSin7 = -76.7058597531f;
+static const float kSin9 = 42.0586939449f;
+static const float kSin11 = -15.0946425768f;
+
+// per call constants shared by every path
+struct WaveConsts
+{
+  float x0;
+  float cyclesPerX; // waves / (x1 - x0)
+  float phase;      // speed * time (cycles the wave has travelled)
+  float lift;
+  float amp;
+};
+
+static WaveConsts waveConsts(const WaveParams &wave)
+{
+  WaveConsts c;
+  c.x0 = wave.x0;
+  c.cyclesPerX = (float)wave.waves / (wave.x1 - wave.x0);
+  c.phase = wave.speed * wave.time;
+  c.lift = wave.lift;
+  c.amp = wave.amp;
+  return c;
+}
+
+#if defined(__AVX2__)
+
+static const size_t kLanes = 8;
+
+// 8 wave heights at once
+static inline __m256 waveKernel(__m256 x, const WaveConsts &c)
+{
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 quarter = _mm256_set1_ps(0.25f);
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+  const __m256 p = _mm256_sub_ps(_mm256_mul_ps(_mm256_sub_ps(x, _mm256_set1_ps(c.x0)), _mm256_set1_ps(c.cyclesPerX)),
+                                 _mm256_set1_ps(c.phase));
+  __m256 f = _mm256_sub_ps(p, _mm256_round_ps(p, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+
+  // fold |f| > 0.25 onto the rising quarter: f = copysign(0.5, f) - f
+  const __m256 s = _mm256_or_ps(_mm256_and_ps(f, signMask), half);
+  const __m256 fold = _mm256_cmp_ps(_mm256_andnot_ps(signMask, f), quarter, _CMP_GT_OQ);
+  f = _mm256_blendv_ps(f, _mm256_sub_ps(s, f), fold);
+
+  // horner in f^2
+  const __m256 f2 = _mm256_mul_ps(f, f);
+  __m256 r = _mm256_set1_ps(kSin11);
+  r = _mm256_add_ps(_mm256_mul_ps(r, f2), _mm256_set1_ps(kSin9));
+  r = _mm256_add_ps(_mm256_mul_ps(r, f2), _mm256_set1_ps(kSin7));
+  r = _mm256_add_ps(_mm256_mul_ps(r, f2), _mm256_set1_ps(kSin5));
+  r = _mm256_add_ps(_mm256_mul_ps(r, f2), _mm256_set1_ps(kSin3));
+  r = _mm256_add_ps(_mm256_mul_ps(r, f2), _mm256_set1_ps(kSin1));
+  r = _mm256_mul_ps(r, f);
+
+  return _mm256_add_ps(_mm256_set1_ps(c.lift), _mm256_mul_ps(_mm256_set1_ps(c.amp), r));
+}
+
+static inline void waveBlock(const float *xs, float *ys, const WaveConsts &c)
+{
+  _mm256_storeu_ps(ys, waveKernel(_mm256_loadu_ps(xs), c));
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+static const size_t kLanes = 4;
+
+// 4 wave heights at once
+static inline __m128 waveKernel(__m128 x, const WaveConsts &c)
+{
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 quarter = _mm_set1_ps(0.25f);
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+
+  const __m128 p = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(x, _mm_set1_ps(c.x0)), _mm_set1_ps(c.cyclesPerX)),
+                              _mm_set1_ps(c.phase));
+  // cvtps rounds to nearest even under the default rounding mode (phase is far below 2^31)
+  __m128 f = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvtps_epi32(p)));
+
+  // fold |f| > 0.25 onto the rising quarter: f = copysign(0.5, f) - f
+  const __m128 s = _mm_or_ps(_mm_and_ps(f, signMask), half);
+  const __m128 fold = _mm_cmpgt_ps(_mm_andnot_ps(signMask, f), quarter);
+  f = _mm_or_ps(_mm_and_ps(fold, _mm_sub_ps(s, f)), _mm_andnot_ps(fold, f));
+
+  const __m128 f2 = _mm_mul_ps(f, f);
+  __m128 r = _mm_set1_ps(kSin11);
+  r = _mm_add_ps(_mm_mul_ps(r, f2), _mm_set1_ps(kSin9));
+  r = _mm_add_ps(_mm_mul_ps(r, f2), _mm_set1_ps(kSin7));
+  r = _mm_add_ps(_mm_mul_ps(r, f2), _mm_set1_ps(kSin5));
+  r = _mm_add_ps(_mm_mul_ps(r, f2), _mm_set1_ps(kSin3));
+  r = _mm_add_ps(_mm_mul_ps(r, f2), _mm_set1_ps(kSin1));
+  r = _mm_mul_ps(r, f);
+
+  return _mm_add_ps(_mm_set1_ps(c.lift), _mm_mul_ps(_mm_set1_ps(c.amp), r));
+}
+
+static inline void waveBlock(const float *xs, float *ys, const WaveConsts &c)
+{
+  _mm_storeu_ps(ys, waveKernel(_mm_loadu_ps(xs), c));
+}
+
+#else
+
+static const size_t kLanes = 1;
+
+// scalar fallback: the same steps one value at a time
+static inline void waveBlock(const float *xs, float *ys, const WaveConsts &c)
+{
+  const float p = (xs[0] - c.x0) * c.cyclesPerX - c.phase;
+  float f = p - std::nearbyint(p);
+
+  const float s = std::copysign(0.5f, f);
+  f = std::fabs(f) > 0.25f ? s - f : f;
+
+  const float f2 = f * f;
+  float r = kSin11;
+  r = r * f2 + kSin9;
+  r = r * f2 + kSin7;
+  r = r * f2 + kSin5;
+  r = r * f2 + kSin3;
+  r = r * f2 + kSin1;
+  r = r * f;
+
+  ys[0] = c.lift + c.amp * r;
+}
+
+#endif
+
+void waveYAtBatch(const WaveParams &wave, const float *xs, float *ys, size_t n)
+{
+  const WaveConsts c = waveConsts(wave);
+
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes)
+    waveBlock(xs + i, ys + i, c);
+
+  // tail: run a padded copy through the same kernel
+  if (i < n)
+  {
+    float xt[kLanes], yt[kLanes];
+    const size_t rest = n - i;
+    for (size_t k = 0; k < kLanes; k++)
+      xt[k] = k < rest ? xs[i + k] : c.x0;
+    waveBlock(xt, yt, c);
+    std::memcpy(ys + i, yt, rest * sizeof(float));
+  }
+}
+
+void waveYAtBatch(const float *xs, float *ys, size_t n)
+{
+  waveYAtBatch(gWave, xs, ys, n);
+}
+
+// single value goes through the batch kernel so it agrees with batched results exactly
+float waveYAt(float x)
+{
+  float y;
+  waveYAtBatch(&x, &y, 1);
+  return y;
+}
@@ -0,0 +1,214 @@
+#include "WaveMesh.h"
+#include "ShaderUtils.h"
+#include <cmath>
+#include <cstddef>
+
+// true when two wave parameter sets would build the same rest geometry
+// (time only moves the surface in the vertex shader; a moving wave gets a wider strip)
+static bool sameWave(const WaveParams &a, const WaveParams &b)
+{
+	return a.width == b.width && a.waves == b.waves && a.amp == b.amp && a.lift == b.lift &&
+				 a.thickZ == b.thickZ && a.baseY == b.baseY && a.x0 == b.x0 && a.x1 == b.x1 &&
+				 (a.speed != 0.0f) == (b.speed != 0.0f);
+}
+
+// round an error tolerance down to a power of sqrt(2) so small camera moves
+// don't rebuild the mesh every frame
+static float quantizeError(float maxError)
+{
+	return std::exp2(std::floor(std::log2(maxError) * 2.0f) * 0.5f);
+}
+
+bool WaveMesh::Update(const WaveParams &wave, float maxError)
+{
+	const float error = quantizeError(maxError > kMinError ? maxError : kMinError);
+	if (built && sameWave(wave, builtFor) && error == builtError)
+		return false;
+
+	Build(wave, error);
+
+	if (!vbos[0])
+		glGenBuffers(2, vbos);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(WaveVertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	builtFor = wave;
+	builtError = error;
+	built = true;
+	if (!vao)
+		vao = RenderQueue::CreateVertexArray(Layout());
+	return true;
+}
+
+// surface sample positions along x for a chord error of at most maxError
+// a chord of length h over a curve with |y''| <= k deviates by at most k h^2 / 8,
+// and for the sine |y''| = (2 pi c)^2 |y - lift| (c = cycles per unit x), so the
+// curvature comes straight from the batched heights
+//
+// samples are placed on the rest surface (time 0). an animated strip starts one
+// wavelength left of x0: wave.vert slides the samples right with the crests (by the
+// fraction of a cycle travelled) and clamps them to [x0, x1], so every sample keeps
+// the phase, and so the curvature, it was placed for
+void WaveMesh::Sample(const WaveParams &wave, float maxError, std::vector<float> &xs) const
+{
+	const float width = wave.x1 - wave.x0;
+	const float cyclesPerX = (float)wave.waves / width;
+	const float twoPiC = 2.0f * glm::pi<float>() * cyclesPerX;
+	const float k2 = twoPiC * twoPiC;
+	const float start = wave.speed != 0.0f && cyclesPerX > 0.0f ? wave.x0 - 1.0f / cyclesPerX : wave.x0;
+
+	// at least four samples per wave so crests and troughs are never skipped
+	const float hMax = cyclesPerX > 0.0f ? std::fmin(0.25f / cyclesPerX, width) : width;
+	const float hMin = hMax / 64.0f;
+
+	xs.clear();
+	xs.push_back(start);
+
+	// take the longest step whose peak curvature (checked at five points across it)
+	// keeps the chord within maxError
+	float probeX[5], probeY[5];
+	float x = start;
+	while (x < wave.x1)
+	{
+		float h = hMax;
+		for (;;)
+		{
+			for (int j = 0; j < 5; j++)
+				probeX[j] = std::fmin(x + h * (float)j * 0.25f, wave.x1);
+			waveYAtBatch(wave, probeX, probeY, 5);
+
+			float peak = 0.0f;
+			for (int j = 0; j < 5; j++)
+				peak = std::fmax(peak, std::fabs(probeY[j] - wave.lift));
+			if (k2 * peak * h * h * 0.125f <= maxError || h <= hMin)
+				break;
+			h *= 0.8f;
+		}
+
+		// avoid a sliver at the right edge
+		x = x + h * 1.25f >= wave.x1 ? wave.x1 : x + h;
+		xs.push_back(x);
+	}
+}
+
+void WaveMesh::Build(const WaveParams &animated, float maxError)
+{
+	WaveParams wave = animated;
+	wave.time = 0.0f;
+
+	vertices.clear();
+	indices.clear();
+
+	const float halfT = wave.thickZ * 0.5f;
+	const float width = wave.x1 - wave.x0;
+
+	// samples land exactly on both edges
+	std::vector<float> xs, ys;
+	Sample(wave, maxError, xs);
+	const int samples = (int)xs.size();
+	ys.resize(samples);
+	waveYAtBatch(wave, xs.data(), ys.data(), xs.size());
+
+	// slope of y = lift + amp * sin(2 pi waves t) gives the surface normal (-dy/dx, 1, 0)
+	const float twoPi = 2.0f * glm::pi<float>();
+	const float cyclesPerX = (float)wave.waves / width;
+
+	auto vertex = [&](float x, float y, float z, glm::vec3 n, glm::vec3 surface = glm::vec3(0.0f))
+	{
+		vertices.push_back({glm::vec3(x, y, z), n, surface});
+		return (unsigned int)vertices.size() - 1;
+	};
+	// two triangles for quad a b c d (counter-clockwise seen from outside)
+	auto quad = [&](unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+	{
+		indices.insert(indices.end(), {a, b, c, a, c, d});
+	};
+
+	// top surface: a pair of vertices (front, back) per sample
+	const unsigned int top = (unsigned int)vertices.size();
+	for (int i = 0; i < samples; i++)
+	{
+		const float slope = wave.amp * twoPi * cyclesPerX * std::cos(twoPi * cyclesPerX * (xs[i] - wave.x0));
+		const glm::vec3 n = glm::normalize(glm::vec3(-slope, 1.0f, 0.0f));
+		vertex(xs[i], ys[i], halfT, n, glm::vec3(1.0f, 1.0f, 1.0f));
+		vertex(xs[i], ys[i], -halfT, n, glm::vec3(1.0f, 1.0f, 1.0f));
+	}
+	for (int i = 0; i + 1 < samples; i++)
+	{
+		const unsigned int a = top + 2 * i;
+		quad(a, a + 2, a + 3, a + 1);
+	}
+
+	// front and back sides from the surface down to the base
+	for (int side = 0; side < 2; side++)
+	{
+		const float z = side == 0 ? halfT : -halfT;
+		const glm::vec3 n(0.0f, 0.0f, side == 0 ? 1.0f : -1.0f);
+		const unsigned int first = (unsigned int)vertices.size();
+		for (int i = 0; i < samples; i++)
+		{
+			vertex(xs[i], wave.baseY, z, n, glm::vec3(0.0f, 0.0f, 1.0f));
+			vertex(xs[i], ys[i], z, n, glm::vec3(1.0f, 0.0f, 1.0f));
+		}
+		for (int i = 0; i + 1 < samples; i++)
+		{
+			const unsigned int a = first + 2 * i;
+			if (side == 0)
+				quad(a, a + 2, a + 3, a + 1);
+			else
+				quad(a, a + 1, a + 3, a + 2);
+		}
+	}
+
+	// bottom rectangle filling the base
+	{
+		const glm::vec3 n(0.0f, -1.0f, 0.0f);
+		const unsigned int a = vertex(wave.x0, wave.baseY, -halfT, n);
+		vertex(wave.x1, wave.baseY, -halfT, n);
+		vertex(wave.x1, wave.baseY, halfT, n);
+		vertex(wave.x0, wave.baseY, halfT, n);
+		quad(a, a + 1, a + 2, a + 3);
+	}
+
+	// left end cap
+	{
+		const glm::vec3 n(-1.0f, 0.0f, 0.0f);
+		const float y = ys[0];
+		const unsigned int a = vertex(wave.x0, wave.baseY, halfT, n);
+		vertex(wave.x0, y, halfT, n, glm::vec3(1.0f, 0.0f, 0.0f));
+		vertex(wave.x0, y, -halfT, n, glm::vec3(1.0f, 0.0f, 0.0f));
+		vertex(wave.x0, wave.baseY, -halfT, n);
+		quad(a, a + 1, a + 2, a + 3);
+	}
+
+	// right end cap
+	{
+		const glm::vec3 n(1.0f, 0.0f, 0.0f);
+		const float y = ys[samples - 1];
+		const unsigned int a = vertex(wave.x1, wave.baseY, -halfT, n);
+		vertex(wave.x1, y, -halfT, n, glm::vec3(1.0f, 0.0f, 0.0f));
+		vertex(wave.x1, y, halfT, n, glm::vec3(1.0f, 0.0f, 0.0f));
+		vertex(wave.x1, wave.baseY, halfT, n);
+		quad(a, a + 1, a + 2, a + 3);
+	}
+}
+
+RenderMesh WaveMesh::Layout() const
+{
+	RenderMesh mesh;
+	if (!built)
+		return mesh;
+	mesh.streams[0] = {vbos[0], ATTRIB_POS, 3, sizeof(WaveVertex), offsetof(WaveVertex, position)};
+	mesh.streams[1] = {vbos[0], ATTRIB_NORMAL, 3, sizeof(WaveVertex), offsetof(WaveVertex, normal)};
+	mesh.streams[2] = {vbos[0], ATTRIB_SURFACE, 3, sizeof(WaveVertex), offsetof(WaveVertex, surface)};
+	mesh.streamCount = 3;
+	mesh.indexBuffer = vbos[1];
+	mesh.indexCount = (GLsizei)indices.size();
+	mesh.vao = vao;
+	return mesh;
+}